@@ -64,9 +64,12 @@ class Demo : public Application {
 
         void summarizer() {
             puts("starting summarizer");
-            DataFrame* result = kvs_->wait_and_get(verify);
-            delete verify; // non-local
+            // ask for the counter's result first, so it travels while we wait for the local value
+            Future* pending = kvs_->wait_and_get_async(verify);
             DataFrame* expected = kvs_->wait_and_get(check); // local
+            DataFrame* result = pending->get();
+            delete pending;
+            delete verify; // non-local
             pln(expected->get_int(0, 0) == result->get_int(0, 0) ? "SUCCESS":"FAILURE");
             delete result; // non-local
             delete main; 
@@ -3,10 +3,10 @@
 #include "../../data/sorer/sorer.h"
 #include "../../data/dataframe/rower.h"
 #include "../../data/dataframe/dataframe.h"
-#include "../../data/dataframe/split.h"
 #include "../../util/set.h"
 #include "../../util/helper.h"
 #include "../../data/kv_store/kvs_impl.h"
+#include "../../data/kv_store/distributed.h"
 
 // this class updates the given project sets with new projects based on new users
 class ProjectFinder : public Rower {
@@ -90,7 +90,10 @@ class Linus : public Application {
         const char* PROJ = "datasets/big/projects.ltgt";
         const char* USER = "datasets/big/users.ltgt";
         const char* COMM = "datasets/big/commits.ltgt";
-        DataFrame* commits;  // pid x uid x uid
+        // true if every node > 0 parses its own byte range of the commits file
+        // else node 0 parses the whole file and spreads its chunks over all the nodes
+        const bool DIST_LOAD = true;
+        DistributedDataFrame* commits;  // pid x uid x uid, chunked across the nodes
         Set* uSet; // Linus' collaborators
         Set* pSet; // projects of collaborators
 
@@ -106,7 +109,7 @@ class Linus : public Application {
 
         // deconstructor
         ~Linus() {
-            // commits deleted by KVStore in teardown
+            delete commits; // only the metadata, the chunks are deleted by KVStore in teardown
             delete uSet;
             delete pSet;
             delete new_users;
@@ -116,29 +119,13 @@ class Linus : public Application {
         void run() override {
             if (this_node() == 0) read_files_(); // node 0 reads file
             else setup_data_(); // nodes wait for data from node 0
+            load_commits_();
             for (step_ = 0; step_ < DEG; ++step_) step_once_();
+            // the network is only torn down once every node is deleted, so the last allreduce
+            // finishes on every node first
             if (this_node() == 0) finish_();
         }
 
-        // splits up the commits DataFrame
-        // and puts each resulting DF in correct node KVStore
-        // assumes commits and num_nodes fields are set
-        // Note: this is a helper for Node 0
-        void split_commits_() {
-            // split up commits and put each node's commits into KVStore
-            DataFrame** node_comms = split_by_row(commits, num_nodes_ - 1);
-            delete commits; // not necessary in Node 0
-            for (int i = 1; i < num_nodes_; ++i) {
-                // send all nodes their commits
-                Key* k = new Key("comms", i); // store node_comms in correct node
-                kvs_->put(k, node_comms[i-1]);
-                delete k; // can delete, not stored locally
-                delete node_comms[i-1];
-            }
-            delete[] node_comms;
-            commits = nullptr;
-        }
-
         // Node 0 reads data from three files (projects, users, commits)
         void read_files_() {
             Key* k;
@@ -150,10 +137,10 @@ class Linus : public Application {
             printf("Node 0: finished reading projects - %d projects total\n", num_projects);
             pSet = new Set(num_projects);
             new_projs = new Set(num_projects);
-            // put num_projects into KVStore
+            // send num_projects to all nodes
             DataFrame* np = DataFrame::from_scalar(num_projects);
             k = new Key("n_proj", 0);
-            kvs_->put(k, np); // don't delete, stored locally
+            kvs_->broadcast(k, np); // don't delete, stored locally
 
             puts("Node 0: starting to read users");
             DataFrame* users = interpret_file(USER, 0, 0);
@@ -162,40 +149,87 @@ class Linus : public Application {
             printf("Node 0: finished reading users - %d users total\n", num_users);
             uSet = new Set(num_users);
             new_users = new Set(num_users);
-            new_users->add(LUID); // add Linus as only new user
-            // put num_users into KVStore
+            // every node starts from Linus as the only new user
+            new_users->add(LUID);
+            uSet->add(LUID);
+            // send num_users to all nodes
             DataFrame* nu = DataFrame::from_scalar(num_users);
             k = new Key("n_user", 0);
-            kvs_->put(k, nu); // don't delete, stored locally
+            kvs_->broadcast(k, nu); // don't delete, stored locally
+
+            if (DIST_LOAD) share_commits_schema_();
+        }
+
+        // infers the schema of the commits file and puts it into the KVStore (as a DataFrame with
+        // no rows) so the other nodes can read their own part of the file with the same schema
+        // Note: this is a helper for Node 0
+        void share_commits_schema_() {
+            Schema* s = infer_schema(COMM);
+            DataFrame* empty = new DataFrame(*s);
+            delete s;
+            Key* k = new Key("c_schema", 0);
+            kvs_->broadcast(k, empty); // don't delete, stored locally
+            puts("Node 0: shared schema of commits");
+        }
+
+        // waits for the schema of the commits file, then reads this node's byte range of the file
+        // nodes 1 to num_nodes_ - 1 each read an equal part of the file, node 0 reads none
+        // returns the rows read (an empty dataframe on node 0)
+        DataFrame* read_commits_chunk_() {
+            Key* k = new Key("c_schema", this_node());
+            DataFrame* empty = kvs_->wait_and_get(k); // broadcast by node 0
+            delete k; // don't delete empty, stored locally
+            if (this_node() == 0) return new DataFrame(empty->get_schema());
 
-            puts("Node 0: starting to read commits");
-            commits = interpret_file(COMM, 0, 0);
-            puts("Node 0: finished reading commits");
-            split_commits_();
+            size_t size = file_size(COMM);
+            size_t chunk = size / (num_nodes_ - 1);
+            size_t from = (this_node() - 1) * chunk;
+            size_t len = this_node() == num_nodes_ - 1 ? size - from : chunk;
+            printf("Node %d: starting to read commits [%lu, %lu)\n", this_node(), from, from + len);
+            // from = 0 and len = 0 means the whole file to the sorer
+            DataFrame* out;
+            if (len == 0) out = new DataFrame(empty->get_schema());
+            else out = interpret_file(COMM, from, len, &(empty->get_schema()), nullptr);
+            printf("Node %d: finished reading commits - %lu commits\n", this_node(), out->nrows());
+            return out;
+        }
+
+        // makes the distributed commits dataframe, every node takes part
+        // with DIST_LOAD the rows each node read become its chunk, else node 0 reads the whole
+        // file and splits it into one chunk per node
+        void load_commits_() {
+            if (DIST_LOAD) {
+                commits = DistributedDataFrame::from_local(kvs_, "comms", read_commits_chunk_());
+            } else if (this_node() == 0) {
+                puts("Node 0: starting to read commits");
+                DataFrame* all = interpret_file(COMM, 0, 0);
+                puts("Node 0: finished reading commits");
+                size_t rows = (all->nrows() + num_nodes_ - 1) / num_nodes_;
+                commits = DistributedDataFrame::from_df(kvs_, "comms", all, rows > 0 ? rows : 1, 0);
+                delete all; // the chunks are copies
+            } else commits = DistributedDataFrame::from_df(kvs_, "comms", nullptr, 0, 0);
         }
 
         // Nodes > 0 wait for the data from Node 0, set up fields once data is received
         void setup_data_() {
+            // both counts are broadcast by node 0 into the local store
+            Key* kp = new Key("n_proj", this_node());
+            Key* ku = new Key("n_user", this_node());
             // 1. Nodes > 0 wait for num_projects - create a set of that size (bitmap style)
-            Key* k = new Key("n_proj", 0);
-            DataFrame* np = kvs_->wait_and_get(k);
+            DataFrame* np = kvs_->wait_and_get(kp);
             int num_projects = np->get_int(0, 0);
             pSet = new Set(num_projects);
             new_projs = new Set(num_projects);
-            delete k;
-            delete np;
             // 2. Nodes > 0 wait for num_users - create a set of that size "
-            k = new Key("n_user", 0);
-            DataFrame* nu = kvs_->wait_and_get(k);
+            DataFrame* nu = kvs_->wait_and_get(ku);
             int num_users = nu->get_int(0, 0);
             uSet = new Set(num_users);
             new_users = new Set(num_users);
-            delete k;
-            delete nu;
-            // 3. Nodes > 0 wait for commits chunk + locally save chunk
-            k = new Key("comms", this_node());
-            commits = kvs_->wait_and_get(k);
-            delete k;
+            // every node starts from Linus as the only new user
+            new_users->add(LUID);
+            uSet->add(LUID);
+            delete kp; // don't delete np or nu, stored locally
+            delete ku;
         }
 
         // converts a set into a dataframe (set elements all go in column 0)
@@ -211,113 +245,68 @@ class Linus : public Application {
             for (size_t i = 0; i < df->nrows(); ++i) set->add(df->get_int(0, i));
         }
 
-        // sends out list of new users, then merges resulting new projects sets
-        // called by node 0
-        void merge_new_projs_() {
-            // 1. Node 0 sends list of newly added users from previous round to all nodes
-            DataFrame* nu = set_to_df_(new_users);
-            Key* k = Key::make_key("nu-", step_, 0);
-            kvs_->put(k, nu); // don't delete key or df (stored locally)
-            // 2. Node 0 combines list of new projects from all nodes into set
-            new_projs->clear();
-            DataFrame* np;
-            for (int i = 1; i < num_nodes_; ++i) {
-                k = Key::make_key("np-", step_, i);
-                np = kvs_->wait_and_get(k);
-                update_set_(np, new_projs);
-                update_set_(np, pSet);
-                delete k; // not local
-                delete np;
-            }
-            printf("Node 0: got new projects from all nodes - %lu new projects\n", new_projs->size());
-        }
-
-        // sends out list of new projects, then merges resulting new user sets
-        // called by node 0
-        void merge_new_users_() {
-            // 3. Node 0 sends set of new projects to all nodes
-            DataFrame* np = set_to_df_(new_projs);
-            Key* k = Key::make_key("np-", step_, 0);
-            kvs_->put(k, np); // don't delete, stored locally
-            // 4. Node 0 combines lists of new users from all nodes into set
-            new_users->clear();
-            DataFrame* nu;
-            for (int i = 1; i < num_nodes_; ++i) {
-                k = Key::make_key("nu-", step_, i);
-                nu = kvs_->wait_and_get(k);
-                update_set_(nu, new_users);
-                update_set_(nu, uSet);
-                delete k;
-                delete nu;
-            }
-            printf("Node 0: got new users from all nodes - %lu new users\n", new_users->size());
+        // unions the given set of every node for this step, named by the given prefix, and puts
+        // the union into the given step set (replacing it) and the given set of all found
+        // every node takes part, node 0 with an empty set, and every node gets the union
+        void union_all_(const char* prefix, Set* step_set, Set* all) {
+            StrBuff sb;
+            sb.c(prefix);
+            sb.c(step_);
+            char* name = sb.get();
+            DataFrame* mine = set_to_df_(step_set);
+            DataFrame* un = kvs_->allreduce(name, MergeOp::Union, mine);
+            step_set->clear();
+            update_set_(un, step_set);
+            update_set_(un, all);
+            delete[] name;
+            delete mine;
+            delete un;
         }
 
-        // calculates new projects
-        // called by nodes > 0
+        // calculates the new projects in this node's chunks of commits based on the new users
         void calc_new_projs_() {
-            // 1. Nodes > 0 wait for DF of newly added users
-            Key* k = Key::make_key("nu-", step_, 0);
-            DataFrame* nu = kvs_->wait_and_get(k);
-            //    - Update local users set to tag new users
-            new_users->clear();
-            update_set_(nu, new_users);
-            update_set_(nu, uSet);
-            delete k; // delete - data stored on node 0
-            delete nu;
-            // 2. Nodes > 0 go through their commits + build up list of new projects
             ProjectFinder* pf = new ProjectFinder(pSet, new_projs, new_users);
             printf("Node %d: started looking for new projects\n", this_node());
             commits->map(*pf);
             printf("Node %d: finished looking for new projects\n", this_node());
             delete pf;
-            // 3. Nodes > 0 send new projects to Node 0
-            DataFrame* np = set_to_df_(new_projs);
-            k = Key::make_key("np-", step_, this_node());
-            kvs_->put(k, np); // don't delete key or df (stored locally)
         }
 
-        // calculates new users
-        // called by nodes > 0
+        // calculates the new users in this node's chunks of commits based on the new projects
         void calc_new_users_() {
-            // 4. Nodes > 0 wait for set of new projects
-            Key* k = Key::make_key("np-", step_, 0);
-            DataFrame* np = kvs_->wait_and_get(k);
-            //    - Update local projects set to tag new projects
-            new_projs->clear();
-            update_set_(np, new_projs);
-            update_set_(np, pSet);
-            delete k; // delete - data stored on 0
-            delete np;
-            // 5. Nodes > 0 go through commits + build up list of new users
-            //    (that worked on new projects)
             UserFinder* uf = new UserFinder(uSet, new_users, new_projs);
             printf("Node %d: stared looking for new users\n", this_node());
             commits->map(*uf);
             printf("Node %d: finished looking for new users\n", this_node());
             delete uf;
-            // 6. Nodes > 0 send list of new users to Node 0
-            DataFrame* nu = set_to_df_(new_users);
-            k = Key::make_key("nu-", step_, this_node());
-            kvs_->put(k, nu); // don't delete (stored locally)
         }
 
         // Tags users in next degree from Linus
+        // each half of a step is an allreduce of the sets of the nodes, so every node starts the
+        // next half with the same new projects/users without node 0 merging and sending them
         void step_once_() {
             printf("Node %d: starting step %d\n", this_node(), step_);
+            // 1. All nodes look for new projects in their own chunks of commits
+            calc_new_projs_();
+            // 2. All nodes union their new projects
+            union_all_("np-", new_projs, pSet);
+            if (this_node() == 0) {
+                printf("Node 0: got new projects from all nodes - %lu new projects\n", new_projs->size());
+            }
+            // 3. All nodes look for new users that worked on the new projects
+            calc_new_users_();
+            // 4. All nodes union their new users
+            union_all_("nu-", new_users, uSet);
             if (this_node() == 0) {
-                merge_new_projs_();
-                merge_new_users_();
-            } else {
-                calc_new_projs_();
-                calc_new_users_();
+                printf("Node 0: got new users from all nodes - %lu new users\n", new_users->size());
             }
         }
 
         // does the last steps of this application (such as printing out answer and network teardown)
         void finish_() {
             kvs_->teardown();
-            printf("SUCCESS: %lu USERS WITHIN %d DEGREES OF LINUS\n", uSet->size(), DEG);
+            // uSet holds Linus too
+            printf("SUCCESS: %lu USERS WITHIN %d DEGREES OF LINUS\n", uSet->size() - 1, DEG);
         }
 };
 
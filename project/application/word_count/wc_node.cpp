@@ -109,58 +109,90 @@ class WordCount : public Application {
             Column** cols = read_words_();
             puts("read all the words");
             // put columns into KVStore for counters to start using
-            char* k_str = new char[strlen("in_000")];
+            char k_str[16]; // fits "in_" followed by any int
             for (int i = 0; i < ctrs_; ++i) {
                 // wrap column in DataFrame
                 Schema* s = new Schema(0, cols[i]->size());
                 DataFrame* df = new DataFrame(*s);
                 df->add_column(cols[i]);
-                sprintf(k_str, "in_%d", i+1); // create key
+                snprintf(k_str, sizeof(k_str), "in_%d", i+1); // create key
                 Key* k = new Key(k_str, fr_idx_);
                 kvs_->put(k, df); // local
                 delete s;
             }
-            delete[] k_str;
             delete[] cols;
         }
 
+        // returns the counter node that owns the count of the given word
+        int owner_(String* word) {
+            return 1 + hash_bytes(word->c_str(), word->size(), 0) % ctrs_;
+        }
+
         // waits for data and then counts the distinct words in this node's corresponding column
+        // each word is counted on the counter node that owns it, so a word that is in the data of
+        // several counters is still only counted once
         void local_count() {
             // Key looks like this: {"in_<this_node>", fr_idx_}
-            char* k_str = new char[strlen("in_000")];
-            sprintf(k_str, "in_%d", this_node());
+            char k_str[16]; // fits "fin_" followed by any int
+            snprintf(k_str, sizeof(k_str), "in_%d", this_node());
             Key* in_k = new Key(k_str, fr_idx_);
             // wait for file reader to put in data for this node
             DataFrame* words = kvs_->wait_and_get(in_k);
             delete in_k; // non-local
             
             printf("Node %d starting local count\n", this_node());
-            for (size_t i = 0; i < words->nrows(); ++i) {
-                // create key for current word: {<word> <this_node>}
-                Key* ki = new Key(words->get_string(0, i)->c_str(), this_node());
-                // get count for current word (will be nullptr if new word)
-                DataFrame* count = kvs_->get(ki);
-                // put in new key/val pair if new word
-                if (count == nullptr) kvs_->put(ki, DataFrame::from_scalar(1));
-                // else just increment the count in the dataframe
+            // increment the counter of every word on its owner, one message per owner
+            // key for each word: {<word> <owner>}
+            size_t n = words->nrows();
+            Key** keys = new Key*[n];
+            DataFrame** ones = new DataFrame*[n];
+            DataFrame* one = DataFrame::from_scalar(1);
+            for (size_t i = 0; i < n; ++i) {
+                String* word = words->get_string(0, i);
+                keys[i] = new Key(word->c_str(), owner_(word));
+                ones[i] = one;
+            }
+            kvs_->merge_many(keys, MergeOp::Add, ones, n);
+            for (size_t i = 0; i < n; ++i) delete keys[i]; // merges keep copies
+            delete[] keys;
+            delete[] ones;
+            delete one;
+            delete words; // non-local
+
+            // tell every counter this node is done, after its merges on the same connection
+            DataFrame* done = DataFrame::from_scalar(this_node());
+            for (int i = 1; i <= ctrs_; ++i) {
+                snprintf(k_str, sizeof(k_str), "fin_%d", this_node());
+                Key* k = new Key(k_str, i);
+                if (i == this_node()) kvs_->put(k, done->clone()); // local
                 else {
-                    count->set(0, 0, count->get_int(0, 0) + 1);
-                    delete ki;
+                    kvs_->put(k, done);
+                    delete k; // non-local
                 }
             }
-             
-            delete words; // non-local
+            delete done;
+
+            // wait until every counter is done with the words this node owns
+            Key** fins = new Key*[ctrs_];
+            DataFrame** fin_vals = new DataFrame*[ctrs_];
+            for (int i = 1; i <= ctrs_; ++i) {
+                snprintf(k_str, sizeof(k_str), "fin_%d", i);
+                fins[i - 1] = new Key(k_str, this_node());
+            }
+            kvs_->wait_and_get_many(fins, ctrs_, fin_vals); // local, values are not copies
+            for (int i = 0; i < ctrs_; ++i) delete fins[i];
+            delete[] fins;
+            delete[] fin_vals;
 
             // puts count into the reduce node's store 
             // key looks like this: {"ct_<this_node>", r_idx_}
-            sprintf(k_str, "ct_%d", this_node());
+            snprintf(k_str, sizeof(k_str), "ct_%d", this_node());
             Key* count_k = new Key(k_str, r_idx_);
-            // NOTE: this does not consider case where words from different sections are not distinct
-            DataFrame* tmp = DataFrame::from_scalar(static_cast<int>(kvs_->local_size()));
+            // every local key is a word this node owns, except the fin_ keys
+            DataFrame* tmp = DataFrame::from_scalar(static_cast<int>(kvs_->local_size() - ctrs_));
             kvs_->put(count_k, tmp);
             delete count_k; // non-local
             delete tmp; // non-local
-            delete[] k_str;
             printf("Node %d done counting\n", this_node());
         }
 
@@ -168,10 +200,10 @@ class WordCount : public Application {
             printf("Node %d reducing counts\n", r_idx_);
             int sum = 0;
             
-            char k_str[strlen("ct_000")];
+            char k_str[16]; // fits "ct_" followed by any int
             // sum up data from all counters
             for (int i = 1; i <= ctrs_; ++i) {
-                sprintf(k_str, "ct_%d", i);
+                snprintf(k_str, sizeof(k_str), "ct_%d", i);
                 Key* k = new Key(k_str, this_node());
                 DataFrame* count = kvs_->wait_and_get(k);
                 sum += count->get_int(0, 0);
@@ -0,0 +1,197 @@
+// Authors: Zoe Corning (corning.z@husky.neu.edu) & Rucha Khanolkar (khanolkar.r@husky.neu.edu)
+#pragma once
+
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "dataframe.h"
+#include "schema.h"
+#include "column.h"
+#include "../../util/object.h"
+#include "../../util/string.h"
+#include "../../util/helper.h"
+
+// Binary columnar file format for DataFrames
+// all numbers are in the byte order of the machine that wrote the file
+//   header:  <magic: 8 bytes> <ncols: u64> <nrows: u64> <arena offset: u64> <arena size: u64>
+//            <col types: ncols chars, padded to 8 bytes> <block offsets: ncols u64>
+//   blocks:  one per column, each starts at an 8 byte aligned offset
+//            B -> nrows bools, I -> nrows ints, F -> nrows floats,
+//            S -> nrows + 1 u64 offsets into the arena (string i is null terminated at offset i)
+//   arena:   the characters of every string in the file
+// bool, int and float blocks are used in place when a file is loaded, strings are copied
+
+const char BIN_MAGIC[] = "EAU2DF01"; // first 8 bytes of every binary DataFrame file
+const size_t BIN_HEADER = 5 * sizeof(uint64_t); // bytes before the column types
+
+// rounds the given size up to a multiple of 8
+size_t align8(size_t n) { return (n + 7) & ~((size_t)7); }
+
+// a whole file mapped into memory
+// the mapping is private, so writes to it are never written back to the file
+class MappedFile : public Object {
+    public:
+        char* data_; // start of the mapping
+        size_t size_; // size of the file and mapping
+
+        // maps the given file
+        MappedFile(const char* path) : Object() {
+            int fd = open(path, O_RDONLY);
+            check(fd >= 0, "Could not open file to map");
+            struct stat st;
+            check(fstat(fd, &st) == 0, "Could not stat file to map");
+            size_ = st.st_size;
+            void* m = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+            check(m != MAP_FAILED, "Could not map file");
+            close(fd); // mapping stays valid
+            data_ = static_cast<char*>(m);
+        }
+
+        // unmaps the file
+        ~MappedFile() {
+            munmap(data_, size_);
+        }
+};
+
+// returns the number of bytes the block of the given column takes up (before alignment)
+size_t block_size(Column* c) {
+    char type = c->get_type();
+    if (type == 'B') return c->size() * sizeof(bool);
+    else if (type == 'I') return c->size() * sizeof(int);
+    else if (type == 'F') return c->size() * sizeof(float);
+    else return (c->size() + 1) * sizeof(uint64_t);
+}
+
+// writes the given DataFrame to the given path in the binary format described above
+// the file is written through a shared mapping
+void save_binary(DataFrame* df, const char* path) {
+    size_t ncols = df->ncols();
+    size_t nrows = df->nrows();
+
+    // lay out the file: header, column blocks, arena
+    size_t* offsets = new size_t[ncols];
+    size_t off = align8(BIN_HEADER + align8(ncols) + ncols * sizeof(uint64_t));
+    size_t arena_size = 0;
+    for (size_t i = 0; i < ncols; ++i) {
+        Column* c = df->get_col_(i);
+        offsets[i] = off;
+        off = align8(off + block_size(c));
+        if (c->get_type() != 'S') continue;
+        for (size_t r = 0; r < nrows; ++r) {
+            String* str = c->as_string()->get(r);
+            arena_size += (str == nullptr ? 0 : str->size()) + 1;
+        }
+    }
+    size_t arena_off = off;
+    size_t total = arena_off + arena_size;
+
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    check(fd >= 0, "Could not create binary file");
+    check(ftruncate(fd, total) == 0, "Could not resize binary file");
+    void* m = mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    check(m != MAP_FAILED, "Could not map binary file");
+    char* base = static_cast<char*>(m);
+
+    // header
+    memcpy(base, BIN_MAGIC, 8);
+    uint64_t* hdr = reinterpret_cast<uint64_t*>(base + 8);
+    hdr[0] = ncols;
+    hdr[1] = nrows;
+    hdr[2] = arena_off;
+    hdr[3] = arena_size;
+    char* types = base + BIN_HEADER;
+    memcpy(types, df->get_schema().col_types_, ncols);
+    uint64_t* block_offs = reinterpret_cast<uint64_t*>(types + align8(ncols));
+    for (size_t i = 0; i < ncols; ++i) block_offs[i] = offsets[i];
+
+    // blocks and arena
+    size_t arena_used = 0;
+    for (size_t i = 0; i < ncols; ++i) {
+        Column* c = df->get_col_(i);
+        char* block = base + offsets[i];
+        char type = c->get_type();
+        if (type == 'B') memcpy(block, c->as_bool()->vals_, block_size(c));
+        else if (type == 'I') memcpy(block, c->as_int()->vals_, block_size(c));
+        else if (type == 'F') memcpy(block, c->as_float()->vals_, block_size(c));
+        else {
+            uint64_t* str_offs = reinterpret_cast<uint64_t*>(block);
+            for (size_t r = 0; r < nrows; ++r) {
+                String* str = c->as_string()->get(r);
+                size_t len = str == nullptr ? 0 : str->size();
+                str_offs[r] = arena_used;
+                if (len > 0) memcpy(base + arena_off + arena_used, str->c_str(), len);
+                base[arena_off + arena_used + len] = '\0';
+                arena_used += len + 1;
+            }
+            str_offs[nrows] = arena_used;
+        }
+    }
+
+    check(munmap(m, total) == 0, "Could not write binary file");
+    close(fd);
+    delete[] offsets;
+}
+
+// returns true if the len bytes at the given offset are inside a file of the given size
+// (written so that a huge offset or length from a corrupt file cannot overflow)
+bool in_file(uint64_t off, uint64_t len, size_t size) {
+    return off <= size && len <= size - off;
+}
+
+// loads the DataFrame stored at the given path in the binary format described above
+// the file is mapped and the bool, int and float columns use the mapping in place, so the
+// returned DataFrame owns the mapping and the file is never copied into memory
+// every offset and length read from the file is checked against its size first, so a truncated or
+// corrupt file fails with an error instead of reading outside the mapping
+DataFrame* load_binary(const char* path) {
+    const char* bad = "Truncated or corrupt binary DataFrame file";
+    MappedFile* mf = new MappedFile(path);
+    char* base = mf->data_;
+    size_t size = mf->size_;
+    check(size >= BIN_HEADER && memcmp(base, BIN_MAGIC, 8) == 0, "Not a binary DataFrame file");
+    uint64_t* hdr = reinterpret_cast<uint64_t*>(base + 8);
+    size_t ncols = hdr[0];
+    size_t nrows = hdr[1];
+    // every column takes at least a byte per row, so larger counts cannot be right (and the
+    // sizes computed from them below cannot overflow)
+    check(ncols <= size && nrows <= size, bad);
+    check(in_file(hdr[2], hdr[3], size), bad);
+    char* arena = base + hdr[2];
+    size_t arena_size = hdr[3];
+    char* types = base + BIN_HEADER;
+    check(in_file(BIN_HEADER, align8(ncols) + ncols * sizeof(uint64_t), size), bad);
+    uint64_t* block_offs = reinterpret_cast<uint64_t*>(types + align8(ncols));
+
+    Schema* s = new Schema(0, nrows);
+    DataFrame* out = new DataFrame(*s);
+    delete s;
+    for (size_t i = 0; i < ncols; ++i) {
+        char type = types[i];
+        size_t width = type == 'B' ? sizeof(bool) : type == 'I' ? sizeof(int)
+                : type == 'F' ? sizeof(float) : sizeof(uint64_t);
+        size_t len = (type == 'S' ? nrows + 1 : nrows) * width;
+        // blocks are used in place, so they also have to be aligned
+        check(block_offs[i] % 8 == 0 && in_file(block_offs[i], len, size), bad);
+        char* block = base + block_offs[i];
+        Column* c = nullptr;
+        if (type == 'B') c = BoolColumn::wrap(reinterpret_cast<bool*>(block), nrows);
+        else if (type == 'I') c = IntColumn::wrap(reinterpret_cast<int*>(block), nrows);
+        else if (type == 'F') c = FloatColumn::wrap(reinterpret_cast<float*>(block), nrows);
+        else if (type == 'S') {
+            uint64_t* str_offs = reinterpret_cast<uint64_t*>(block);
+            check(str_offs[nrows] <= arena_size, bad);
+            StringColumn* sc = new StringColumn(nrows);
+            for (size_t r = 0; r < nrows; ++r) {
+                // each string is followed by its terminator, so it ends before the next one
+                check(str_offs[r] < str_offs[r + 1] && str_offs[r + 1] <= str_offs[nrows], bad);
+                sc->set(r, new String(arena + str_offs[r], str_offs[r + 1] - str_offs[r] - 1));
+            }
+            c = sc;
+        } else check(false, "Invalid type in binary DataFrame file");
+        out->add_column(c);
+    }
+    out->backing_ = mf;
+    return out;
+}
@@ -66,11 +66,13 @@ class BoolColumn : public Column {
     public:
 
         bool* vals_;
+        bool external_; // true if vals_ is not owned (ex. it points into a mapped file)
         size_t cap_;
         size_t size_;
 
         // initializes this boolean column as an empty column
         BoolColumn() {
+            external_ = false;
             size_ = 0;
             cap_ = 4;
             vals_ = new bool[cap_];
@@ -80,6 +82,7 @@ class BoolColumn : public Column {
         // capacity will be maxed with 1 if given 0
         // all values initialized to 0
         BoolColumn(size_t size) {
+            external_ = false;
             if (size == 0) cap_ = 1;
             else cap_ = size;
             vals_ = new bool[cap_];
@@ -91,6 +94,7 @@ class BoolColumn : public Column {
         // then a variable number of bools to fill the column
         // behavior is undefined if the given arguments are not bools
         BoolColumn(int n, ...) {
+            external_ = false;
             if (n == 0) cap_ = 1;
             else cap_ = n;
             va_list args;
@@ -109,7 +113,20 @@ class BoolColumn : public Column {
 
         // deconstructor for this boolean column
         ~BoolColumn() {
-            delete[] vals_;
+            if (!external_) delete[] vals_;
+        }
+
+        // creates a column that uses the given array of the given size in place (no copy)
+        // the array is external and must outlive this column, it is copied once the column grows
+        static BoolColumn* wrap(bool* vals, size_t size) {
+            BoolColumn* out = new BoolColumn();
+            if (size == 0) return out;
+            delete[] out->vals_;
+            out->vals_ = vals;
+            out->size_ = size;
+            out->cap_ = size;
+            out->external_ = true;
+            return out;
         }
 
         /** Returns the number of elements in the column. */
@@ -138,8 +155,9 @@ class BoolColumn : public Column {
             for (size_t i = 0; i < size_; ++i) {
                 new_vals[i] = vals_[i];
             }
-            delete[] vals_;
+            if (!external_) delete[] vals_;
             vals_ = new_vals;
+            external_ = false;
         }
 
         // pushes the given boolean into this column
@@ -198,11 +216,13 @@ class IntColumn : public Column {
     public:
 
         int* vals_;
+        bool external_; // true if vals_ is not owned (ex. it points into a mapped file)
         size_t cap_;
         size_t size_;
 
         // initializes this integer column as an empty column
         IntColumn() {
+            external_ = false;
             size_ = 0;
             cap_ = 4;
             vals_ = new int[cap_]; 
@@ -212,6 +232,7 @@ class IntColumn : public Column {
         // capacity will be maxed with 1 if given 0
         // all values initialized to 0
         IntColumn(size_t size) {
+            external_ = false;
             if (size == 0) cap_ = 1;
             else cap_ = size;
             vals_ = new int[cap_];
@@ -223,6 +244,7 @@ class IntColumn : public Column {
         // then a variable number of ints to fill the column
         // behavior is undefined if the given arguments are not ints
         IntColumn(int n, ...) {
+            external_ = false;
             if (n == 0) cap_ = 1;
             else cap_ = n;
             
@@ -240,7 +262,20 @@ class IntColumn : public Column {
 
         // deconstructor for this integer column
         ~IntColumn() {
-            delete[] vals_;
+            if (!external_) delete[] vals_;
+        }
+
+        // creates a column that uses the given array of the given size in place (no copy)
+        // the array is external and must outlive this column, it is copied once the column grows
+        static IntColumn* wrap(int* vals, size_t size) {
+            IntColumn* out = new IntColumn();
+            if (size == 0) return out;
+            delete[] out->vals_;
+            out->vals_ = vals;
+            out->size_ = size;
+            out->cap_ = size;
+            out->external_ = true;
+            return out;
         }
 
         /** Returns the number of elements in the column. */
@@ -269,8 +304,9 @@ class IntColumn : public Column {
             for (size_t i = 0; i < size_; ++i) {
                 new_vals[i] = vals_[i];
             }
-            delete[] vals_;
+            if (!external_) delete[] vals_;
             vals_ = new_vals;
+            external_ = false;
         }
 
         // pushes the given integer into this column
@@ -330,11 +366,13 @@ class FloatColumn : public Column {
     public:
 
         float* vals_;
+        bool external_; // true if vals_ is not owned (ex. it points into a mapped file)
         size_t size_;
         size_t cap_;
 
         // initializes this float column as an empty column
         FloatColumn() {
+            external_ = false;
             size_ = 0;
             cap_ = 4;
             vals_ = new float[cap_];
@@ -344,6 +382,7 @@ class FloatColumn : public Column {
         // capacity will be maxed with 1 if given 0
         // all values initalized to 0
         FloatColumn(size_t size) {
+            external_ = false;
             if (size == 0) cap_ = 1;
             else cap_ = size;
             vals_ = new float[cap_];
@@ -355,6 +394,7 @@ class FloatColumn : public Column {
         // then a variable number of floats to fill the column
         // behavior is undefined if the given arguments are not floats
         FloatColumn(int n, ...) {
+            external_ = false;
             if (n == 0) cap_ = 1;
             else cap_ = n;
             
@@ -375,7 +415,20 @@ class FloatColumn : public Column {
 
         // deconstructor for this float column
         ~FloatColumn() {
-            delete[] vals_;
+            if (!external_) delete[] vals_;
+        }
+
+        // creates a column that uses the given array of the given size in place (no copy)
+        // the array is external and must outlive this column, it is copied once the column grows
+        static FloatColumn* wrap(float* vals, size_t size) {
+            FloatColumn* out = new FloatColumn();
+            if (size == 0) return out;
+            delete[] out->vals_;
+            out->vals_ = vals;
+            out->size_ = size;
+            out->cap_ = size;
+            out->external_ = true;
+            return out;
         }
 
         /** Returns the number of elements in the column. */
@@ -404,8 +457,9 @@ class FloatColumn : public Column {
             for (size_t i = 0; i < size_; ++i) {
                 new_vals[i] = vals_[i];
             }
-            delete[] vals_;
+            if (!external_) delete[] vals_;
             vals_ = new_vals;
+            external_ = false;
         }
 
         // pushes the given float into this column
@@ -562,7 +616,7 @@ class StringColumn : public Column {
             for (size_t i = 0; i < size_; ++i) {
                 if (i != 0) sb->c(DLM);
                 char* tmp = duplicate(vals_[i]->c_str());
-                char to_esc[] = {ESC, DLM, '}', ']', '\n'};
+                char to_esc[] = {ESC, DLM, '}', ']', '\n', '\0'};
                 char* tmp2 = add_escapes(tmp, to_esc);
                 delete[] tmp;
                 sb->c(tmp2);
@@ -6,6 +6,7 @@
 #pragma once
 
 #include <thread>
+#include <vector>
 #include "../../util/object.h"
 #include "../../util/string.h"
 #include "../../util/helper.h"
@@ -95,6 +96,7 @@ class DataFrame : public Object {
         size_t cap_;
 
         Row* row_; // used so you don't have to reallocate memory
+        Object* backing_; // owned, memory that columns use in place (ex. a mapped file) or nullptr
  
         /** Create a data frame with the same columns as the given df but with no rows or row names */
         DataFrame(DataFrame& df) {
@@ -113,6 +115,7 @@ class DataFrame : public Object {
             }
 
             row_ = nullptr;
+            backing_ = nullptr;
         }
  
         /** Create a data frame from a schema and columns. All columns are created
@@ -130,6 +133,7 @@ class DataFrame : public Object {
             }
 
             row_ = nullptr;
+            backing_ = nullptr;
         }
 
         ~DataFrame() {
@@ -140,6 +144,7 @@ class DataFrame : public Object {
             }
             delete[] cols_;
             delete row_;
+            delete backing_; // after the columns that may point into it
         }
 
         /** Returns the dataframe's schema. Modifying the schema after a dataframe
@@ -428,6 +433,111 @@ class DataFrame : public Object {
             return out;
         }
 
+        // returns a copy of this dataframe that shares no memory with it (strings are copied too)
+        DataFrame* clone() {
+            DataFrame* out = new DataFrame(*s_);
+            size_t n = nrows();
+            for (size_t i = 0; i < ncols(); ++i) {
+                Column* from = cols_[i];
+                Column* to = out->cols_[i];
+                char type = from->get_type();
+                if (type == 'B') memcpy(to->as_bool()->vals_, from->as_bool()->vals_, n * sizeof(bool));
+                else if (type == 'I') memcpy(to->as_int()->vals_, from->as_int()->vals_, n * sizeof(int));
+                else if (type == 'F') {
+                    memcpy(to->as_float()->vals_, from->as_float()->vals_, n * sizeof(float));
+                } else {
+                    for (size_t r = 0; r < n; ++r) {
+                        String* str = from->as_string()->get(r);
+                        to->as_string()->set(r, str == nullptr ? nullptr : str->clone());
+                    }
+                }
+            }
+            return out;
+        }
+
+        // returns a copy of the rows [from, to) of this dataframe that shares no memory with it
+        DataFrame* slice(size_t from, size_t to) {
+            check(from <= to && to <= nrows(), "Slice out of bounds");
+            size_t n = to - from;
+            Schema* s = new Schema(0, n);
+            for (size_t i = 0; i < ncols(); ++i) s->add_column(s_->col_type(i));
+            DataFrame* out = new DataFrame(*s);
+            delete s;
+            for (size_t i = 0; i < ncols(); ++i) {
+                Column* c = cols_[i];
+                Column* to_c = out->cols_[i];
+                char type = c->get_type();
+                if (type == 'B') {
+                    memcpy(to_c->as_bool()->vals_, c->as_bool()->vals_ + from, n * sizeof(bool));
+                } else if (type == 'I') {
+                    memcpy(to_c->as_int()->vals_, c->as_int()->vals_ + from, n * sizeof(int));
+                } else if (type == 'F') {
+                    memcpy(to_c->as_float()->vals_, c->as_float()->vals_ + from, n * sizeof(float));
+                } else {
+                    for (size_t r = 0; r < n; ++r) {
+                        String* str = c->as_string()->get(from + r);
+                        to_c->as_string()->set(r, str == nullptr ? nullptr : str->clone());
+                    }
+                }
+            }
+            return out;
+        }
+
+        // returns a copy of the given rows of this dataframe, in the given order, that shares no
+        // memory with it
+        DataFrame* select(std::vector<size_t>& rows) {
+            size_t n = rows.size();
+            for (size_t r : rows) check(r < nrows(), "Select out of bounds");
+            Schema* s = new Schema(0, n);
+            for (size_t i = 0; i < ncols(); ++i) s->add_column(s_->col_type(i));
+            DataFrame* out = new DataFrame(*s);
+            delete s;
+            for (size_t i = 0; i < ncols(); ++i) {
+                Column* c = cols_[i];
+                Column* to_c = out->cols_[i];
+                char type = c->get_type();
+                if (type == 'B') {
+                    bool* from = c->as_bool()->vals_;
+                    bool* to = to_c->as_bool()->vals_;
+                    for (size_t r = 0; r < n; ++r) to[r] = from[rows[r]];
+                } else if (type == 'I') {
+                    int* from = c->as_int()->vals_;
+                    int* to = to_c->as_int()->vals_;
+                    for (size_t r = 0; r < n; ++r) to[r] = from[rows[r]];
+                } else if (type == 'F') {
+                    float* from = c->as_float()->vals_;
+                    float* to = to_c->as_float()->vals_;
+                    for (size_t r = 0; r < n; ++r) to[r] = from[rows[r]];
+                } else {
+                    for (size_t r = 0; r < n; ++r) {
+                        String* str = c->as_string()->get(rows[r]);
+                        to_c->as_string()->set(r, str == nullptr ? nullptr : str->clone());
+                    }
+                }
+            }
+            return out;
+        }
+
+        // returns roughly how many bytes the values of this dataframe take up in memory
+        size_t mem_size() {
+            size_t n = nrows();
+            size_t out = sizeof(DataFrame) + ncols() * sizeof(Column*);
+            for (size_t i = 0; i < ncols(); ++i) {
+                char type = cols_[i]->get_type();
+                if (type == 'B') out += n * sizeof(bool);
+                else if (type == 'I') out += n * sizeof(int);
+                else if (type == 'F') out += n * sizeof(float);
+                else {
+                    out += n * sizeof(String*);
+                    for (size_t r = 0; r < n; ++r) {
+                        String* str = cols_[i]->as_string()->get(r);
+                        if (str != nullptr) out += sizeof(String) + str->size() + 1;
+                    }
+                }
+            }
+            return out;
+        }
+
         // serializes this DataFrame into the following format:
         // <col_types> <nrows> [[<data00> <data01> <data02> ...] [...] ...]
         // column: [<data0> <data1> <data2>]
@@ -14,12 +14,14 @@ class Splitter : public Rower {
         size_t n_; // number of resulting dataframes
         size_t next_; // index of next DataFrame to receive a row
         
-        // creates a splitter with n empty dataframes
-        Splitter(size_t n, const char* col_types) {
+        // creates a splitter with n empty dataframes with the columns of the given schema
+        Splitter(size_t n, Schema& scm) {
             check(n > 0, "Cannot split into less than 2 DataFrames");
             n_ = n;
             dfs_ = new DataFrame*[n];
-            Schema* s = new Schema(col_types); // ncols = cols, 0 = rows
+            // col_types_ is not null terminated, so the columns are copied one by one
+            Schema* s = new Schema(); // 0 rows
+            for (size_t i = 0; i < scm.width(); ++i) s->add_column(scm.col_type(i));
             for (size_t i = 0; i < n; ++i) {
                 dfs_[i] = new DataFrame(*s);
             }
@@ -50,7 +52,7 @@ class Splitter : public Rower {
 // splits the given dataframe into n dataframes by row
 // returns array of DataFrame* of size n with nrows = df->nrows()/n
 DataFrame** split_by_row(DataFrame* df, size_t n) {
-    Splitter* sp = new Splitter(n, df->get_schema().col_types_);
+    Splitter* sp = new Splitter(n, df->get_schema());
     df->map(*sp);
     DataFrame** out = sp->get_dfs();
     delete sp;
@@ -0,0 +1,116 @@
+// Authors: Zoe Corning(corning.z@husky.neu.edu) & Rucha Khanolkar(khanolkar.r@husky.neu.edu)
+
+#pragma once
+
+#include "key.h"
+#include "lru.h"
+#include "../../util/object.h"
+#include "../../util/helper.h"
+#include "../../util/thread.h"
+#include "../dataframe/dataframe.h"
+
+// a copy of a remote value kept in a RemoteCache
+class CacheEntry : public LruEntry {
+    public:
+        DataFrame* df_; // owned copy of the value
+
+        // copies the given key, takes ownership of the given dataframe
+        CacheEntry(Key* k, DataFrame* df, size_t bytes) : LruEntry(k, bytes) {
+            df_ = df;
+        }
+
+        ~CacheEntry() {
+            delete df_;
+        }
+};
+
+// local copies of values fetched from other nodes, so reading the same value again does not
+// go over the network or deserialize it again
+// only values that never change once put should be cached, a key that is put again must be
+// invalidated by the caller
+// the copies take up at most budget_ bytes, the least recently used ones are dropped first
+// thread safe
+class RemoteCache : public Object {
+    public:
+        size_t budget_; // most bytes the cached values can take up
+        LruTable* entries_; // owned, the cached values (CacheEntry)
+        size_t hits_; // number of gets answered from the cache
+        size_t misses_; // number of gets that were not
+        Lock lock_; // guards every field
+
+        // creates an empty cache that keeps at most budget bytes of values
+        RemoteCache(size_t budget) : Object() {
+            budget_ = budget;
+            entries_ = new LruTable();
+            hits_ = 0;
+            misses_ = 0;
+        }
+
+        ~RemoteCache() {
+            delete entries_;
+        }
+
+        // returns a copy (owned by the caller) of the cached value of the given key
+        // returns nullptr if the value is not cached
+        DataFrame* get(Key* k) {
+            lock_.lock();
+            CacheEntry* e = static_cast<CacheEntry*>(entries_->get(k));
+            DataFrame* out = nullptr;
+            if (e != nullptr) {
+                entries_->touch(e);
+                out = e->df_->clone();
+                ++hits_;
+            } else ++misses_;
+            lock_.unlock();
+            return out;
+        }
+
+        // caches a copy of the given value for the given key (both stay owned by the caller)
+        // drops the least recently used values until the cache fits in its budget
+        // a value bigger than the whole budget is not cached
+        void put(Key* k, DataFrame* v) {
+            size_t bytes = v->mem_size();
+            if (bytes > budget_) return;
+            CacheEntry* e = new CacheEntry(k, v->clone(), bytes);
+            lock_.lock();
+            delete entries_->take(k);
+            while (entries_->used_ + bytes > budget_) delete entries_->take(entries_->tail_->key_);
+            entries_->add(e);
+            lock_.unlock();
+        }
+
+        // drops the cached value of the given key, if there is one
+        void invalidate(Key* k) {
+            lock_.lock();
+            delete entries_->take(k);
+            lock_.unlock();
+        }
+
+        // drops the cached values of the keys that start with the given prefix
+        void invalidate_prefix(const char* prefix) {
+            lock_.lock();
+            LruEntry* e = entries_->head_;
+            while (e != nullptr) {
+                LruEntry* next = e->next_;
+                if (starts_with(e->key_->str_, prefix)) delete entries_->take(e->key_);
+                e = next;
+            }
+            lock_.unlock();
+        }
+
+        // returns the number of cached values
+        size_t size() {
+            lock_.lock();
+            size_t out = entries_->size_;
+            lock_.unlock();
+            return out;
+        }
+
+        // returns the number of bytes the cached values take up
+        size_t used() {
+            lock_.lock();
+            size_t out = entries_->used_;
+            lock_.unlock();
+            return out;
+        }
+};
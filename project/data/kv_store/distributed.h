@@ -0,0 +1,348 @@
+// Authors: Zoe Corning(corning.z@husky.neu.edu) & Rucha Khanolkar(khanolkar.r@husky.neu.edu)
+
+#pragma once
+
+#include <limits.h>
+#include <float.h>
+#include "key.h"
+#include "merge.h"
+#include "kvs_impl.h"
+#include "../../util/object.h"
+#include "../../util/string.h"
+#include "../../util/helper.h"
+#include "../dataframe/dataframe.h"
+#include "../dataframe/rower.h"
+#include "../dataframe/row.h"
+
+// a DataFrame whose rows are split into chunks stored in the KVStores of different nodes, so it
+// does not have to fit in the memory of one node or travel in one message
+// chunk i holds the rows [starts_[i], starts_[i + 1]) and is the value of the key
+// {<name>-<i>, homes_[i]}
+// every node has a DistributedDataFrame with the same metadata (schema, row ranges, homes), and
+// the operations are called by every node in the same order: each node works on the chunks that
+// are homed on it, and the operations that combine results use the collectives of the KVStore
+// NOTE: the chunks are owned by the stores, deleting a DistributedDataFrame only deletes its
+// metadata
+class DistributedDataFrame : public Object {
+    public:
+        KVStore* kvs_; // not owned, the store of this node
+        char* name_; // owned, name of the dataframe, part of every chunk key
+        Schema* schema_; // owned, the column types (no rows)
+        size_t nchunks_; // number of chunks
+        size_t* starts_; // owned, first row of each chunk, starts_[nchunks_] is the number of rows
+        int* homes_; // owned, index of the node that stores each chunk
+        size_t ops_; // number of collectives this dataframe has run, names the next one
+
+        // takes ownership of the given schema, starts and homes, copies the name
+        DistributedDataFrame(KVStore* kvs, const char* name, Schema* schema, size_t nchunks,
+                size_t* starts, int* homes) : Object() {
+            kvs_ = kvs;
+            name_ = duplicate(name);
+            schema_ = schema;
+            nchunks_ = nchunks;
+            starts_ = starts;
+            homes_ = homes;
+            ops_ = 0;
+        }
+
+        ~DistributedDataFrame() {
+            delete[] name_;
+            delete schema_;
+            delete[] starts_;
+            delete[] homes_;
+        }
+
+        // makes a distributed dataframe out of the given local rows of every node
+        // every node calls it with the same name and its own rows (owned by the store from now on,
+        // all with the same schema), and the rows of node i become chunk i
+        // only the number of rows of each node is exchanged, in one allreduce
+        static DistributedDataFrame* from_local(KVStore* kvs, const char* name, DataFrame* local) {
+            size_t n = kvs->node_->num_nodes_;
+            int idx = kvs->get_idx();
+            int* homes = new int[n];
+            for (size_t i = 0; i < n; ++i) homes[i] = i;
+            kvs->put(chunk_key_(name, idx, idx), local); // don't delete, stored locally
+            int* counts = new int[n];
+            memset(counts, 0, n * sizeof(int));
+            counts[idx] = local->nrows();
+            size_t* starts = starts_of_(kvs, name, n, counts);
+            delete[] counts;
+            return new DistributedDataFrame(kvs, name, types_of_(local), n, starts, homes);
+        }
+
+        // makes a distributed dataframe out of the given dataframe of the given root node
+        // every node calls it with the same name and root, and only the root passes a dataframe
+        // (not owned, the others pass nullptr) and the number of rows per chunk
+        // the root copies the rows into chunks of chunk_rows rows (in order), homes chunk i on
+        // node i % (number of nodes), sends each node all of its chunks in one message and
+        // broadcasts the metadata, so no chunk is sent more than once
+        static DistributedDataFrame* from_df(KVStore* kvs, const char* name, DataFrame* df,
+                size_t chunk_rows, int root) {
+            int idx = kvs->get_idx();
+            Key* meta_k = new Key(name, idx);
+            if (idx == root) {
+                check(df != nullptr && chunk_rows > 0, "DistributedDataFrame: Nothing to split");
+                size_t nrows = df->nrows();
+                size_t nchunks = nrows == 0 ? 1 : (nrows + chunk_rows - 1) / chunk_rows;
+                Key** keys = new Key*[nchunks];
+                DataFrame** chunks = new DataFrame*[nchunks];
+                // metadata, one row per chunk: <first row> <number of rows> <home>
+                int* meta_vals = new int[nchunks * 3];
+                for (size_t i = 0; i < nchunks; ++i) {
+                    size_t from = i * chunk_rows;
+                    size_t to = from + chunk_rows < nrows ? from + chunk_rows : nrows;
+                    int home = i % kvs->node_->num_nodes_;
+                    keys[i] = chunk_key_(name, i, home);
+                    chunks[i] = df->slice(from, to);
+                    meta_vals[i] = from;
+                    meta_vals[nchunks + i] = to - from;
+                    meta_vals[2 * nchunks + i] = home;
+                }
+                kvs->put_many(keys, chunks, nchunks);
+                for (size_t i = 0; i < nchunks; ++i) {
+                    if (keys[i]->idx_ == idx) continue; // stored locally
+                    delete keys[i];
+                    delete chunks[i];
+                }
+                delete[] keys;
+                delete[] chunks;
+
+                Schema* ms = new Schema(0, nchunks);
+                for (size_t i = 0; i < 3; ++i) ms->add_column('I');
+                DataFrame* meta = new DataFrame(*ms);
+                delete ms;
+                for (size_t c = 0; c < 3; ++c) {
+                    for (size_t i = 0; i < nchunks; ++i) meta->set(c, i, meta_vals[c * nchunks + i]);
+                }
+                delete[] meta_vals;
+                // the column types go in a second broadcast, as a dataframe with no rows
+                DataFrame* types = df->slice(0, 0);
+                kvs->broadcast(meta_k, meta); // don't delete, stored locally
+                kvs->broadcast(types_key_(name, idx), types); // stored locally
+            }
+
+            // the metadata is broadcast by the root into the local store
+            DataFrame* meta = kvs->wait_and_get(meta_k);
+            Key* types_k = types_key_(name, idx);
+            DataFrame* types = kvs->wait_and_get(types_k);
+            delete types_k; // the stored keys are the broadcast ones
+            if (idx != root) delete meta_k;
+
+            size_t nchunks = meta->nrows();
+            size_t* starts = new size_t[nchunks + 1];
+            int* homes = new int[nchunks];
+            for (size_t i = 0; i < nchunks; ++i) {
+                starts[i] = meta->get_int(0, i);
+                homes[i] = meta->get_int(2, i);
+            }
+            starts[nchunks] = starts[nchunks - 1] + meta->get_int(1, nchunks - 1);
+            return new DistributedDataFrame(kvs, name, types_of_(types), nchunks, starts, homes);
+        }
+
+        // returns the key of the given chunk of the dataframe with the given name
+        static Key* chunk_key_(const char* name, size_t i, int home) {
+            StrBuff sb;
+            sb.c(name);
+            sb.c('-');
+            sb.c(i);
+            char* str = sb.get();
+            Key* out = new Key(str, home);
+            delete[] str;
+            return out;
+        }
+
+        // returns the key the root of from_df broadcasts the schema of the given dataframe under
+        static Key* types_key_(const char* name, int idx) {
+            StrBuff sb;
+            sb.c(name);
+            sb.c("-types");
+            char* str = sb.get();
+            Key* out = new Key(str, idx);
+            delete[] str;
+            return out;
+        }
+
+        // returns a copy of the column types of the given dataframe, with no rows
+        static Schema* types_of_(DataFrame* df) {
+            Schema* out = new Schema();
+            for (size_t i = 0; i < df->ncols(); ++i) out->add_column(df->get_schema().col_type(i));
+            return out;
+        }
+
+        // adds up the given row counts of the n chunks (0 for the chunks of other nodes) over
+        // every node, in one allreduce under the given name
+        // returns the first row of each chunk, followed by the total number of rows
+        static size_t* starts_of_(KVStore* kvs, const char* name, size_t n, int* counts) {
+            DataFrame* mine = DataFrame::from_array(n, counts);
+            DataFrame* all = kvs->allreduce(name, MergeOp::Add, mine);
+            size_t* out = new size_t[n + 1];
+            out[0] = 0;
+            for (size_t i = 0; i < n; ++i) out[i + 1] = out[i] + all->get_int(0, i);
+            delete mine;
+            delete all;
+            return out;
+        }
+
+        // returns a new name for the next collective or derived dataframe: <name>#<ops_>
+        char* next_name_() {
+            StrBuff sb;
+            sb.c(name_);
+            sb.c('#');
+            sb.c(ops_++);
+            return sb.get();
+        }
+
+        // removes the chunks stored on this node, and the metadata from_df stored here, and
+        // deletes them (ex. once a filtered dataframe is used), every node calls it and the
+        // dataframe cannot be used afterwards
+        void drop() {
+            int idx = kvs_->get_idx();
+            for (size_t i = 0; i < nchunks_; ++i) {
+                if (! is_local(i)) continue;
+                Key* k = chunk_key_(name_, i, idx);
+                kvs_->remove(k);
+                delete k;
+            }
+            Key* k = new Key(name_, idx);
+            kvs_->remove(k); // nothing to remove if it was made by from_local or filter
+            delete k;
+            k = types_key_(name_, idx);
+            kvs_->remove(k);
+            delete k;
+        }
+
+        // returns the number of rows
+        size_t nrows() { return starts_[nchunks_]; }
+
+        // returns the number of columns
+        size_t ncols() { return schema_->width(); }
+
+        // returns the column types (the schema has no rows)
+        Schema& get_schema() { return *schema_; }
+
+        // returns true if the given chunk is stored on this node
+        bool is_local(size_t i) { return homes_[i] == kvs_->get_idx(); }
+
+        // returns the given chunk, once it is stored
+        // a local chunk is the stored value, a remote one is a copy owned by the caller
+        DataFrame* chunk(size_t i) {
+            check(i < nchunks_, "DistributedDataFrame: Chunk out of bounds");
+            Key* k = chunk_key_(name_, i, homes_[i]);
+            DataFrame* out = kvs_->wait_and_get(k);
+            delete k;
+            return out;
+        }
+
+        // visits the rows of the chunks stored on this node, in order
+        void map(Rower& r) {
+            for (size_t i = 0; i < nchunks_; ++i) if (is_local(i)) chunk(i)->map(r);
+        }
+
+        // like map, but the rows of each local chunk are split between threads that each visit
+        // them with a clone of the rower (see DataFrame::pmap)
+        void pmap(Rower& r) {
+            for (size_t i = 0; i < nchunks_; ++i) if (is_local(i)) chunk(i)->pmap(r);
+        }
+
+        // runs the given rower over each chunk on the node that stores it (see KVStore::execute),
+        // all chunks at once, and returns the result of each chunk (an array of nchunks_ results,
+        // owned by the caller) - only the calling node takes part, and no chunk is sent
+        // the result of a chunk that is not stored yet is nullptr
+        DataFrame** execute(RemoteRower& r) {
+            Future** futures = new Future*[nchunks_];
+            for (size_t i = 0; i < nchunks_; ++i) {
+                Key* k = chunk_key_(name_, i, homes_[i]);
+                futures[i] = kvs_->execute_async(k, r);
+                delete k; // the request is sent or run already
+            }
+            DataFrame** out = new DataFrame*[nchunks_];
+            for (size_t i = 0; i < nchunks_; ++i) {
+                out[i] = futures[i]->get();
+                delete futures[i];
+            }
+            delete[] futures;
+            return out;
+        }
+
+        // makes a new distributed dataframe of the rows the given rower accepts
+        // every node filters the chunks stored on it, and chunk i of the result stays on the node
+        // of chunk i, so only the row counts are exchanged
+        // the rower of each node only sees the rows of that node
+        DistributedDataFrame* filter(Rower& r) {
+            char* name = next_name_();
+            int* counts = new int[nchunks_];
+            memset(counts, 0, nchunks_ * sizeof(int));
+            for (size_t i = 0; i < nchunks_; ++i) {
+                if (! is_local(i)) continue;
+                DataFrame* c = chunk(i);
+                std::vector<size_t> rows; // the accepted rows, copied in one pass
+                Row* row = new Row(c->get_schema());
+                for (size_t j = 0; j < c->nrows(); ++j) {
+                    c->fill_row(j, *row);
+                    if (r.accept(*row)) rows.push_back(j);
+                }
+                delete row;
+                DataFrame* kept = c->select(rows);
+                counts[i] = kept->nrows();
+                kvs_->put(chunk_key_(name, i, homes_[i]), kept); // stored locally
+            }
+            size_t* starts = starts_of_(kvs_, name, nchunks_, counts);
+            int* homes = new int[nchunks_];
+            memcpy(homes, homes_, nchunks_ * sizeof(int));
+            DistributedDataFrame* out = new DistributedDataFrame(kvs_, name, new Schema(*schema_),
+                    nchunks_, starts, homes);
+            delete[] counts;
+            delete[] name;
+            return out;
+        }
+
+        // combines the values of the given int or float column over all the rows with the given
+        // operation (Add, Min or Max)
+        // every node folds the rows of its own chunks, then the partial results are combined in
+        // one allreduce
+        // returns a 1x1 dataframe (owned by the caller) on every node, which holds 0 for Add, and
+        // the biggest (Min) or smallest (Max) value of the type if there are no rows
+        DataFrame* aggregate(size_t col, MergeOp op) {
+            check(col < ncols(), "DistributedDataFrame: Column out of bounds");
+            check(op == MergeOp::Add || op == MergeOp::Min || op == MergeOp::Max,
+                    "DistributedDataFrame: Operation cannot aggregate");
+            char type = schema_->col_type(col);
+            check(type == 'I' || type == 'F', "DistributedDataFrame: Column cannot be aggregated");
+            DataFrame* mine = nullptr;
+            if (type == 'I') {
+                int acc = op == MergeOp::Add ? 0 : op == MergeOp::Min ? INT_MAX : INT_MIN;
+                for (size_t i = 0; i < nchunks_; ++i) {
+                    if (! is_local(i)) continue;
+                    DataFrame* c = chunk(i);
+                    for (size_t j = 0; j < c->nrows(); ++j) acc = fold_(op, acc, c->get_int(col, j));
+                }
+                mine = DataFrame::from_scalar(acc);
+            } else {
+                float acc = op == MergeOp::Add ? 0 : op == MergeOp::Min ? FLT_MAX : -FLT_MAX;
+                for (size_t i = 0; i < nchunks_; ++i) {
+                    if (! is_local(i)) continue;
+                    DataFrame* c = chunk(i);
+                    for (size_t j = 0; j < c->nrows(); ++j) acc = fold_(op, acc, c->get_float(col, j));
+                }
+                mine = DataFrame::from_scalar(acc);
+            }
+            char* name = next_name_();
+            DataFrame* out = kvs_->allreduce(name, op, mine);
+            delete[] name;
+            delete mine;
+            return out;
+        }
+
+        // combines the given values with the given operation (Add, Min or Max)
+        static int fold_(MergeOp op, int a, int b) {
+            if (op == MergeOp::Add) return a + b;
+            if (op == MergeOp::Min) return b < a ? b : a;
+            return b > a ? b : a;
+        }
+
+        static float fold_(MergeOp op, float a, float b) {
+            if (op == MergeOp::Add) return a + b;
+            if (op == MergeOp::Min) return b < a ? b : a;
+            return b > a ? b : a;
+        }
+};
@@ -0,0 +1,167 @@
+// Authors: Zoe Corning(corning.z@husky.neu.edu) & Rucha Khanolkar(khanolkar.r@husky.neu.edu)
+
+#pragma once
+
+#include <vector>
+#include "key.h"
+#include "../../util/object.h"
+#include "../../util/helper.h"
+#include "../../util/thread.h"
+#include "../dataframe/dataframe.h"
+
+// a DataFrame that may not be available yet
+// complete() is called once with the value, and get() blocks until it has been called
+// subclasses can override complete() to act on the value as soon as it arrives
+class Future : public Object {
+    public:
+        Lock lock_; // guards val_ and ready_
+        DataFrame* val_; // not owned, the value once ready_ is true
+        bool ready_; // true once complete() is called
+        Key* key_; // not owned, the key this future waits for while it is in a FutureTable
+        size_t id_; // id of the request this future waits for while it is in a RequestTable
+        Future* next_; // next future in the same FutureTable or RequestTable bucket
+        // true if a local value this is completed with must stay alive and in memory until the
+        // future calls KVStore::release_ for it (see KVShard and SpillStore)
+        bool pin_;
+
+        Future() : Object(), val_(nullptr), ready_(false), key_(nullptr), id_(0), next_(nullptr),
+                pin_(false) { }
+
+        virtual ~Future() { }
+
+        // sets the value of this future and wakes up the threads blocked in get()
+        virtual void complete(DataFrame* v) {
+            lock_.lock();
+            val_ = v;
+            ready_ = true;
+            lock_.notify_all();
+            lock_.unlock();
+        }
+
+        // returns true if the value is available
+        bool ready() {
+            lock_.lock();
+            bool out = ready_;
+            lock_.unlock();
+            return out;
+        }
+
+        // waits until the value is available, then returns it
+        DataFrame* get() {
+            lock_.lock();
+            while (!ready_) lock_.wait();
+            DataFrame* out = val_;
+            lock_.unlock();
+            return out;
+        }
+};
+
+// completes each future of the given chain (linked through next_, may be nullptr) with the given
+// value
+void complete_chain(Future* f, DataFrame* v) {
+    while (f != nullptr) {
+        Future* next = f->next_; // f may be gone once it is completed
+        f->complete(v);
+        f = next;
+    }
+}
+
+// the futures waiting for keys that are not in a store yet, grouped by key
+// futures are chained through Future::next_ in buckets picked by key hash, so finding the
+// waiters of a key only looks at the few futures in its bucket
+// not thread safe, the owner guards it with its own lock
+class FutureTable : public Object {
+    public:
+        static const size_t BUCKETS = 64;
+        Future* buckets_[BUCKETS]; // futures are not owned
+        size_t size_; // number of futures in the table
+
+        FutureTable() : Object(), size_(0) {
+            memset(buckets_, 0, sizeof(buckets_));
+        }
+
+        // returns the bucket for the given key
+        Future** bucket_(Key* k) { return &buckets_[k->hash() % BUCKETS]; }
+
+        // adds the given future, which waits for the given key (not owned, must outlive the wait)
+        void add(Key* k, Future* f) {
+            Future** b = bucket_(k);
+            f->key_ = k;
+            f->next_ = *b;
+            *b = f;
+            ++size_;
+        }
+
+        // removes every future waiting for the given key
+        // returns them chained through next_ (nullptr if there are none)
+        Future* take(Key* k) {
+            Future* out = nullptr;
+            Future** cur = bucket_(k);
+            while (*cur != nullptr) {
+                Future* f = *cur;
+                if (f->key_->equals(k)) {
+                    *cur = f->next_;
+                    f->next_ = out;
+                    out = f;
+                    --size_;
+                } else cur = &f->next_;
+            }
+            return out;
+        }
+};
+
+// the futures of requests sent to other nodes that have not been answered yet, by request id
+// every request gets a new id, so each reply completes exactly the future that sent it
+// not thread safe, the owner guards it with its own lock
+class RequestTable : public Object {
+    public:
+        static const size_t BUCKETS = 64;
+        Future* buckets_[BUCKETS]; // futures are not owned
+        size_t size_; // number of futures in the table
+        size_t next_id_; // id given to the next request, ids start at 1
+
+        RequestTable() : Object(), size_(0), next_id_(1) {
+            memset(buckets_, 0, sizeof(buckets_));
+        }
+
+        // adds the given future under a new request id and returns the id
+        size_t add(Future* f) {
+            f->id_ = next_id_++;
+            Future** b = &buckets_[f->id_ % BUCKETS];
+            f->next_ = *b;
+            *b = f;
+            ++size_;
+            return f->id_;
+        }
+
+        // removes and returns the future of the request with the given id
+        // returns nullptr if no request has that id
+        Future* take(size_t id) {
+            for (Future** cur = &buckets_[id % BUCKETS]; *cur != nullptr; cur = &(*cur)->next_) {
+                Future* f = *cur;
+                if (f->id_ != id) continue;
+                *cur = f->next_;
+                f->next_ = nullptr;
+                --size_;
+                return f;
+            }
+            return nullptr;
+        }
+};
+
+// one batch of a prefix scan (see KVStore::scan_async), complete once the keys have arrived
+// the keys are owned, and so are the values if they were sent by another node (local values
+// are the ones in the store, as with get)
+class ScanFuture : public Future {
+    public:
+        std::vector<Key*> keys_; // the keys of the batch, in order
+        std::vector<DataFrame*> vals_; // value of each key, nullptr if values were not asked for
+        bool owns_vals_; // true if the values are copies sent by another node
+
+        ScanFuture() : Future(), owns_vals_(false) { }
+
+        ~ScanFuture() {
+            for (Key* k : keys_) delete k;
+            if (owns_vals_) for (DataFrame* v : vals_) delete v;
+        }
+};
@@ -2,7 +2,9 @@
 
 #pragma once
 
+#include <vector>
 #include "key.h"
+#include "key_index.h"
 #include "../../util/helper.h"
 #include "../../util/object.h"
 #include "../dataframe/dataframe.h"
@@ -42,18 +44,33 @@ class MapPair : public Object {
 };
 
 // map from Key* to DataFrame*
-// map is a hash map that uses linear probing for efficiency
+// map is an open addressing hash map that uses linear probing
+// a key is looked for starting at the slot hash % cap_ (cap_ is a power of 2), and the hash of the
+// key in each slot is cached next to the slot, so most slots are skipped without touching the pair
+// removed pairs stay in their slot as tombstones so the probe sequences through them still work,
+// and are reused by later puts or dropped when the table is rebuilt, which remove() does once they
+// take up a quarter of the table or the table is mostly empty
+// once the map is first scanned, the live keys are also kept in an ordered KeyIndex, so the keys
+// that start with a prefix can be listed in order without walking the table - a map that is never
+// scanned does not pay for the index on its puts and removes
 class KDMap : public Object {
     public:
-        MapPair** pairs_; // array and pairs are owned, but not keys/dataframes
+        MapPair** pairs_; // array and pairs are owned, but not keys/dataframes, nullptr if empty
+        size_t* hashes_; // owned, the hash of the key of the pair in the same slot
         size_t size_; // number of key/value pairs in this map
-        size_t cap_; // capacity of the array used to store the map data
+        size_t tombs_; // number of slots holding a removed pair
+        size_t cap_; // capacity of the array used to store the map data, a power of 2
+        KeyIndex index_; // the keys of the pairs that are not removed, in order, once indexed_
+        bool indexed_; // true once index_ is built, after which puts and removes keep it up to date
 
         // creates an empty map
         KDMap() : Object() {
             size_ = 0;
+            tombs_ = 0;
             cap_ = 4; // Default cap = 4
+            indexed_ = false;
             pairs_ = new MapPair*[cap_];
+            hashes_ = new size_t[cap_];
             memset(pairs_, 0, sizeof(MapPair*) * cap_);
         }
 
@@ -64,65 +81,102 @@ class KDMap : public Object {
                 delete pairs_[i];
             }
             delete[] pairs_;
+            delete[] hashes_;
         }
 
         // returns the number of pairs in this map
         size_t size() { return size_; }
 
+
         // this is a PRIVATE helper method to find the index of the given key
         // if the index cannot be found, retuns cap_ + 1
         size_t index_of_(Key* key) {
-            for (size_t i = 0; i < cap_; ++i) {
-                if (pairs_[i] != nullptr && pairs_[i]->same_key(key) && !pairs_[i]->tomb_) return i;
+            size_t h = key->hash();
+            size_t mask = cap_ - 1;
+            for (size_t i = h & mask; pairs_[i] != nullptr; i = (i + 1) & mask) {
+                if (hashes_[i] == h && !pairs_[i]->tomb_ && pairs_[i]->same_key(key)) return i;
             }
             return cap_ + 1;
         }
 
-        // this is a PRIVATE method to grow the size of the array if necessary
-        void grow_() {
+        // this is a PRIVATE method that rebuilds the table with the given capacity (a power of 2)
+        // tombstones are not copied
+        void rehash_(size_t cap) {
             MapPair** old_pairs = pairs_;
+            size_t* old_hashes = hashes_;
             size_t old_cap = cap_;
-            cap_ *= 2;
+            cap_ = cap;
             pairs_ = new MapPair*[cap_];
+            hashes_ = new size_t[cap_];
             memset(pairs_, 0, sizeof(MapPair*) * cap_);
-            size_ = 0;
+            tombs_ = 0;
 
+            size_t mask = cap_ - 1;
             for (size_t i = 0; i < old_cap; ++i) {
-                if (old_pairs[i] != nullptr && !old_pairs[i]->tomb_) {
-                    put_pair_(old_pairs[i]);
+                MapPair* mp = old_pairs[i];
+                if (mp == nullptr) continue;
+                if (mp->tomb_) {
+                    delete mp;
+                    continue;
                 }
+                size_t j = old_hashes[i] & mask;
+                while (pairs_[j] != nullptr) j = (j + 1) & mask;
+                pairs_[j] = mp;
+                hashes_[j] = old_hashes[i];
             }
 
             delete[] old_pairs;
+            delete[] old_hashes;
+        }
+
+        // this is a PRIVATE method that rebuilds the table once removed pairs take up a quarter of
+        // it or the pairs fill at most a sixteenth of it, at the smallest size that the pairs fill
+        // at most a quarter of, so a map that had most of its keys removed gives back its memory
+        // (a table that is shrunk has to grow by half before it doubles again)
+        void compact_() {
+            if (tombs_ * 4 < cap_ && (size_ * 16 > cap_ || cap_ <= 4)) return;
+            size_t cap = 4;
+            while (size_ * 4 > cap) cap *= 2;
+            rehash_(cap);
+        }
+
+        // this is a PRIVATE method to make room for one more pair if necessary
+        // the used slots (pairs and tombstones) are kept at most half of the table, the table
+        // doubles if the pairs alone fill a quarter of it, otherwise it is rebuilt at the same
+        // size to clear out the tombstones
+        void grow_() {
+            if ((size_ + tombs_ + 1) * 2 <= cap_) return;
+            if ((size_ + 1) * 4 > cap_) rehash_(cap_ * 2);
+            else rehash_(cap_);
         }
    
         // this is a private helper method to put the given MapPair into this Map
         // if the key already exists in the map, then its value is replaced and returned
         // else the return value is nullptr
         DataFrame* put_pair_(MapPair* mp) {
-            if (cap_/(size_ + 1) < 2) grow_();
-
             size_t idx = index_of_(mp->key_);
-            // key is not already in the map
-            if (idx > cap_) {
-                size_t i = mp->hash_key() % cap_;
-                bool placed = 0;
-                while (!placed) {
-                    MapPair* cur = pairs_[i];
-                    if (cur == nullptr || cur->tomb_) {
-                        if (cur != nullptr) delete cur;
-                        pairs_[i] = mp;
-                        placed = 1;
-                    }
-                    i = mod(i + 1, cap_);
-                }
-                ++size_;
-                return nullptr;
-            } else { // key is already in the map -> replace value
+            // key is already in the map -> replace value
+            if (idx < cap_) {
                 DataFrame* out = pairs_[idx]->set_val(mp->val_);
                 delete mp;
                 return out;
             }
+
+            // key is not already in the map -> the first empty slot or tombstone of its probe
+            grow_();
+            size_t h = mp->hash_key();
+            size_t mask = cap_ - 1;
+            size_t i = h & mask;
+            while (pairs_[i] != nullptr && !pairs_[i]->tomb_) i = (i + 1) & mask;
+            if (pairs_[i] != nullptr) {
+                delete pairs_[i];
+                --tombs_;
+            }
+            pairs_[i] = mp;
+            hashes_[i] = h;
+            if (indexed_) index_.add(mp->key_);
+            ++size_;
+            return nullptr;
         }
 
         // puts the given key and value into this map
@@ -142,32 +196,74 @@ class KDMap : public Object {
             }
         }
 
+        // returns the key this map holds for the given key (an equal key), or nullptr if there is none
+        Key* key_of(Key* key) {
+            size_t idx = index_of_(key);
+            return idx > cap_ ? nullptr : pairs_[idx]->key_;
+        }
+
         // returns true if this map contains the given key
         bool contains_key(Key* k) {
             return index_of_(k) < cap_;
         }
 
         // removes the given key/dataframe pair from this map
+        // the key and dataframe are not deleted (see key_of to get the key this map held)
         DataFrame* remove(Key* key) {
             size_t idx = index_of_(key);
             if (idx > cap_) {
                 return nullptr;
             } else {
+                DataFrame* out = pairs_[idx]->val_;
+                if (indexed_) index_.remove(pairs_[idx]->key_);
                 pairs_[idx]->tomb_ = 1;
                 --size_;
-                return pairs_[idx]->val_;
+                ++tombs_;
+                compact_();
+                return out;
+            }
+        }
+
+        // adds the keys of this map that start with the given prefix to out (the keys are the
+        // ones this map holds, not copies)
+        void keys_with_prefix(const char* prefix, std::vector<Key*>& out) {
+            build_index();
+            index_.scan(prefix, nullptr, SIZE_MAX, out);
+        }
+
+        // adds to out, in order, at most max of the keys of this map that start with the given
+        // prefix and come after the given key string (from the first if after is nullptr)
+        // the keys are the ones this map holds, not copies
+        void scan(const char* prefix, const char* after, size_t max, std::vector<Key*>& out) {
+            build_index();
+            index_.scan(prefix, after, max, out);
+        }
+
+        // builds the ordered index of the live keys if it is not built yet (see indexed_)
+        void build_index() {
+            if (indexed_) return;
+            for (size_t i = 0; i < cap_; ++i) {
+                if (pairs_[i] != nullptr && !pairs_[i]->tomb_) index_.add(pairs_[i]->key_);
             }
+            indexed_ = true;
         }
 
         // deletes all the keys and values in this map
+        // removed pairs were handed back by remove(), so only the pair itself is deleted
         void delete_all() {
             for (size_t i = 0; i < cap_; ++i) {
                 if (pairs_[i] != nullptr) {
-                    delete pairs_[i]->key_;
-                    delete pairs_[i]->val_;
+                    if (!pairs_[i]->tomb_) {
+                        delete pairs_[i]->key_;
+                        delete pairs_[i]->val_;
+                    }
                     delete pairs_[i];
                     pairs_[i] = nullptr;
                 }
             }
+            size_ = 0;
+            tombs_ = 0;
+            index_.clear();
+            indexed_ = false;
         }
 };
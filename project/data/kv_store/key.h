@@ -7,16 +7,21 @@
 #include "../../util/helper.h"
 
 // key class used for Distributed Key-Value Storage
+// the hash of a key is computed once when it is created
 class Key : public Object {
     public:
         char* str_; // string of the key - String is owned
+        size_t len_; // length of str_
         int idx_; // index of the node that owns this data
         
         // constructor
         Key(const char* string, int index) : Object() {
-            str_ = duplicate(string);
+            len_ = strlen(string);
+            str_ = new char[len_ + 1];
+            memcpy(str_, string, len_ + 1);
             check(index >= 0, "Index of key cannot be negative");
             idx_ = index;
+            hash_ = hash_me();
         }
 
         // deconstructor - deletes str_ since it is copied in the constructor
@@ -25,19 +30,17 @@ class Key : public Object {
         }
 
         // determines if this key is equal to the given object
+        // the cached hashes are compared first, so different keys rarely compare their strings
         bool equals(Object* other) { 
             Key* ok = dynamic_cast<Key*>(other);
-            return ok != nullptr && streq(ok->str_, str_) && ok->idx_ == idx_;
+            return ok != nullptr && ok->hash_ == hash_ && ok->idx_ == idx_ && ok->len_ == len_
+                && memcmp(ok->str_, str_, len_) == 0;
         }
 
-        // hashes this key
+        // hashes this key (the string and the index)
         size_t hash_me() {
-            size_t hash = 0;
-            for (size_t i = 0; i < strlen(str_); ++i) {
-                hash += str_[i];
-            }
-            hash += idx_;
-            return hash;
+            size_t hash = hash_bytes(str_, len_, idx_);
+            return hash == 0 ? 1 : hash; // 0 means the hash is not computed yet
         }
 
         // serializes the given key into the following format:
@@ -45,7 +48,7 @@ class Key : public Object {
         char* serialize() {
             StrBuff* sb = new StrBuff();
             char* tmp = duplicate(str_);
-            char to_esc[] = {ESC, '\n', DLM, '|', ']', '}'};
+            char to_esc[] = {ESC, '\n', DLM, '|', ']', '}', '\0'};
             char* esc_tmp = add_escapes(tmp, to_esc);
             delete[] tmp;
             sb->c(esc_tmp);
@@ -0,0 +1,71 @@
+// Authors: Zoe Corning(corning.z@husky.neu.edu) & Rucha Khanolkar(khanolkar.r@husky.neu.edu)
+
+#pragma once
+
+#include <set>
+#include <vector>
+#include <algorithm>
+#include "key.h"
+#include "../../util/object.h"
+#include "../../util/helper.h"
+
+// orders keys by their string (byte by byte), then by their index
+struct KeyLess {
+    bool operator()(Key* a, Key* b) const {
+        int c = strcmp(a->str_, b->str_);
+        return c < 0 || (c == 0 && a->idx_ < b->idx_);
+    }
+};
+
+// an ordered set of keys, kept next to a hash map of the same keys so the keys that start with a
+// prefix can be listed in order without looking at every key of the map
+// the keys starting with a prefix are next to each other in the order, so a scan finds the first
+// one in log(size) steps and only visits the ones it returns
+// the keys are not owned, and must not be deleted while they are in the index
+// not thread safe, the owner guards it with its own lock
+class KeyIndex : public Object {
+    public:
+        std::set<Key*, KeyLess> keys_;
+
+        // adds the given key to this index
+        void add(Key* k) { keys_.insert(k); }
+
+        // removes the key equal to the given key from this index
+        void remove(Key* k) { keys_.erase(k); }
+
+        // removes every key from this index
+        void clear() { keys_.clear(); }
+
+        // returns the number of keys in this index
+        size_t size() { return keys_.size(); }
+
+        // adds to out, in order, at most max of the keys that start with the given prefix and
+        // whose string comes after the given one (from the first key if after is nullptr)
+        // the keys added are the ones in this index, not copies
+        // returns the number of keys added
+        size_t scan(const char* prefix, const char* after, size_t max, std::vector<Key*>& out) {
+            const char* from = after != nullptr && strcmp(after, prefix) > 0 ? after : prefix;
+            Key probe(from, 0); // before every key with the string, indices are not negative
+            size_t n = 0;
+            for (auto it = keys_.lower_bound(&probe); it != keys_.end() && n < max; ++it) {
+                if (! starts_with((*it)->str_, prefix)) break;
+                if (after != nullptr && strcmp((*it)->str_, after) <= 0) continue;
+                out.push_back(*it);
+                ++n;
+            }
+            return n;
+        }
+};
+
+// sorts the given keys (owned) in the order of KeyLess, deletes the ones equal to the key before
+// them and then the ones after the first max
+// used to merge the scans of several indexes into one batch
+void sort_keys(std::vector<Key*>& keys, size_t max) {
+    std::sort(keys.begin(), keys.end(), KeyLess());
+    size_t n = 0;
+    for (size_t i = 0; i < keys.size(); ++i) {
+        if (n < max && (n == 0 || ! keys[n - 1]->equals(keys[i]))) keys[n++] = keys[i];
+        else delete keys[i];
+    }
+    keys.resize(n);
+}
@@ -2,6 +2,9 @@
 
 #pragma once
 
+#include <map>
+#include <set>
+#include <vector>
 #include "../../util/object.h"
 #include "../../util/string.h"
 #include "../../util/helper.h"
@@ -9,8 +12,259 @@
 #include "../dataframe/dataframe.h"
 #include "key.h"
 #include "kd_map.h"
+#include "key_index.h"
+#include "future.h"
+#include "cache.h"
+#include "merge.h"
+#include "remote.h"
+#include "ring.h"
 
 class Node;
+class SpillStore;
+
+const size_t KV_SHARDS = 16; // number of shards the local part of a KVStore is split into
+
+// returns the index of the shard that holds the given key
+// the high bits of the hash pick the shard, since the low bits pick the slot within its map
+size_t shard_index(Key* k) { return (k->hash() >> 32) % KV_SHARDS; }
+
+// one shard of the local part of a KVStore
+// lookups hold the lock for reading, so they run in parallel with each other
+// threads waiting for a key that is not here yet register a Future under that key, and a put
+// completes only the futures of its own key with the value it stored
+// the listener pins the values it serializes after the lock is released (see get and
+// Future::pin_): a pinned value that a merge replaces or that is removed is only deleted by its
+// last release
+class KVShard : public Object {
+    public:
+        KDMap* kdm_; // owned, maps the keys of this shard to their data
+        RWLock* lock_; // owned, lock for the kdmap and the waiting futures
+        FutureTable* waiting_; // owned, futures waiting for keys of this shard (futures not owned)
+        std::map<DataFrame*, size_t> pins_; // number of pins of each pinned value
+        std::set<DataFrame*> retired_; // owned, pinned values that are no longer in the kdmap
+        Lock pin_lock_; // lock for pins_ and retired_, so reads can pin under the read lock
+
+        KVShard() : Object() {
+            kdm_ = new KDMap();
+            lock_ = new RWLock();
+            waiting_ = new FutureTable();
+        }
+
+        ~KVShard() {
+            delete_retired();
+            delete kdm_;
+            delete lock_;
+            delete waiting_;
+        }
+
+        // puts the given key and value into this shard and completes the futures waiting for it
+        // if waiting is not nullptr, the futures are handed back through it (a chain linked by
+        // next_, see complete_chain) instead, so the caller can complete them outside its own locks
+        void put(Key* k, DataFrame* v, Future** waiting = nullptr) {
+            lock_->lock_write();
+            kdm_->put(k, v);
+            Future* f = take_waiting_(k, v);
+            lock_->unlock_write();
+            if (waiting != nullptr) *waiting = f;
+            else complete_chain(f, v);
+        }
+
+        // applies the given operation to the value of the given key under the write lock, so
+        // concurrent merges of the same key are never lost
+        // Add, Or, Min and Max change the value in place, Append and Union do too unless it is
+        // pinned, in which case they change a copy that replaces it (see drop)
+        // a key that is not here yet is stored (as a copy of the key) with a copy of v, and the
+        // futures waiting for it are completed
+        // the key and v are not owned
+        // returns the value that was stored
+        // if waiting is not nullptr, the futures are handed back through it instead (see put)
+        DataFrame* merge(Key* k, MergeOp op, DataFrame* v, Future** waiting = nullptr) {
+            lock_->lock_write();
+            DataFrame* out = kdm_->get(k);
+            Future* f = nullptr;
+            if (out == nullptr) {
+                out = v->clone();
+                kdm_->put(new Key(k->str_, k->idx_), out);
+                f = take_waiting_(k, out);
+            } else if (! changes_rows(op) || ! pinned_(out)) {
+                merge_into(op, out, v);
+            } else {
+                // the listener may be reading the rows a structural merge would move
+                DataFrame* old = out;
+                out = old->clone();
+                merge_into(op, out, v);
+                kdm_->put(k, out);
+                drop(old);
+            }
+            lock_->unlock_write();
+            if (waiting != nullptr) *waiting = f;
+            else complete_chain(f, out);
+            return out;
+        }
+
+        // gets the DataFrame for the given Key, or nullptr if it is not in this shard
+        // if pin is true the value is pinned, and is not deleted until release is called for it
+        DataFrame* get(Key* k, bool pin = false) {
+            lock_->lock_read();
+            DataFrame* out = kdm_->get(k);
+            if (out != nullptr && pin) pin_(out);
+            lock_->unlock_read();
+            return out;
+        }
+
+        // releases a pin of the given value taken by get or for a future, and deletes the value
+        // if it was the last pin of a value that is no longer in this shard
+        void release(DataFrame* v) {
+            pin_lock_.lock();
+            std::map<DataFrame*, size_t>::iterator it = pins_.find(v);
+            check(it != pins_.end(), "KVShard: Value is not pinned");
+            bool last = --it->second == 0;
+            if (last) pins_.erase(it);
+            bool gone = last && retired_.erase(v) == 1;
+            pin_lock_.unlock();
+            if (gone) delete v;
+        }
+
+        // deletes the given value, which is no longer in this shard, or leaves it to the last
+        // release of its pins if it is pinned
+        void drop(DataFrame* v) {
+            pin_lock_.lock();
+            bool held = pins_.count(v) == 1;
+            if (held) retired_.insert(v);
+            pin_lock_.unlock();
+            if (! held) delete v;
+        }
+
+        // returns true if the value of the given key is pinned
+        bool pinned(Key* k) {
+            lock_->lock_read();
+            DataFrame* v = kdm_->get(k);
+            bool out = v != nullptr && pinned_(v);
+            lock_->unlock_read();
+            return out;
+        }
+
+        // completes the given future with the value of the given key as soon as it is in this
+        // shard (right away if it already is)
+        // the value is pinned for the future if it asks for it (see Future::pin_)
+        // the key is not owned and must stay alive until the future is completed
+        void when_present(Key* k, Future* f) {
+            lock_->lock_write();
+            DataFrame* out = kdm_->get(k);
+            if (out == nullptr) waiting_->add(k, f);
+            else if (f->pin_) pin_(out);
+            lock_->unlock_write();
+            if (out != nullptr) f->complete(out);
+        }
+
+        // waits until the given key is in this shard, then returns the corresponding DataFrame
+        DataFrame* wait_and_get(Key* k) {
+            DataFrame* out = get(k);
+            if (out != nullptr) return out;
+            Future f;
+            when_present(k, &f);
+            return f.get();
+        }
+
+        // removes the given key from this shard and returns its DataFrame (nullptr if it is not here)
+        // sets stored to the key this shard held for it, which is now owned by the caller
+        // the DataFrame may still be pinned, so a caller that is done with it passes it to drop
+        DataFrame* remove(Key* k, Key** stored) {
+            lock_->lock_write();
+            *stored = kdm_->key_of(k);
+            DataFrame* out = kdm_->remove(k);
+            lock_->unlock_write();
+            return out;
+        }
+
+        // adds copies (owned by the caller) of the keys of this shard that start with the given
+        // prefix to out
+        void keys_with_prefix(const char* prefix, std::vector<Key*>& out) {
+            std::vector<Key*> held;
+            lock_read_indexed_();
+            kdm_->keys_with_prefix(prefix, held);
+            for (Key* k : held) out.push_back(new Key(k->str_, k->idx_));
+            lock_->unlock_read();
+        }
+
+        // adds copies (owned by the caller) of at most max of the keys of this shard that start
+        // with the given prefix and come after the given key string (from the first if after is
+        // nullptr) to out, in order
+        void scan(const char* prefix, const char* after, size_t max, std::vector<Key*>& out) {
+            std::vector<Key*> held;
+            lock_read_indexed_();
+            kdm_->scan(prefix, after, max, held);
+            for (Key* k : held) out.push_back(new Key(k->str_, k->idx_));
+            lock_->unlock_read();
+        }
+
+        // deletes the pinned values that are no longer in this shard and forgets every pin
+        // @pre the listener is done with the values it pinned
+        void delete_retired() {
+            pin_lock_.lock();
+            for (DataFrame* df : retired_) delete df;
+            retired_.clear();
+            pins_.clear();
+            pin_lock_.unlock();
+        }
+
+        // adds a pin to the given value
+        void pin_(DataFrame* v) {
+            pin_lock_.lock();
+            ++pins_[v];
+            pin_lock_.unlock();
+        }
+
+        // returns true if the given value is pinned
+        bool pinned_(DataFrame* v) {
+            pin_lock_.lock();
+            bool out = pins_.count(v) == 1;
+            pin_lock_.unlock();
+            return out;
+        }
+
+        // takes the futures waiting for the given key, which is being stored with the given value,
+        // and pins the value for each of them that asks for it (see Future::pin_)
+        // @pre the write lock is held
+        Future* take_waiting_(Key* k, DataFrame* v) {
+            if (waiting_->size_ == 0) return nullptr;
+            Future* out = waiting_->take(k);
+            for (Future* f = out; f != nullptr; f = f->next_) if (f->pin_) pin_(v);
+            return out;
+        }
+
+        // takes the read lock once the ordered index of the map is built
+        // the first scan builds it under the write lock, since building it changes the map
+        void lock_read_indexed_() {
+            lock_->lock_read();
+            if (kdm_->indexed_) return;
+            lock_->unlock_read();
+            lock_->lock_write();
+            kdm_->build_index(); // does nothing if another scan built it in the meantime
+            lock_->unlock_write();
+            lock_->lock_read();
+        }
+
+        // gets the number of keys in this shard
+        size_t size() {
+            lock_->lock_read();
+            size_t out = kdm_->size();
+            lock_->unlock_read();
+            return out;
+        }
+};
+
+// adds copies (owned by the caller) of the first max keys of the given KV_SHARDS shards that
+// start with the given prefix and come after the given key string (from the first if after is
+// nullptr) to out, in order
+// each shard lists its first max keys from its own index, and the lists are merged
+void scan_shards(KVShard** shards, const char* prefix, const char* after, size_t max,
+        std::vector<Key*>& out) {
+    std::vector<Key*> keys;
+    for (size_t i = 0; i < KV_SHARDS; ++i) shards[i]->scan(prefix, after, max, keys);
+    sort_keys(keys, max);
+    out.insert(out.end(), keys.begin(), keys.end());
+}
 
 // implementation can be found in kvs_impl.h
 // needed to separated declaration and implementation to resolve circular dependencies with node 
@@ -20,14 +274,22 @@ class Node;
 class KVStore : public Object {
     public:
         Node* node_;
-        KDMap* kdm_; // maps the keys for this node to this node's data (i.e. Key->idx_ == idx_)
-        Lock* kdm_lock_; // lock for the kdmap
+        // the keys for this node and this node's data (i.e. Key->idx_ == idx_), split into shards
+        // by key hash so threads using different keys rarely share a lock
+        KVShard** shards_;
         int idx_; // index of the node that owns this store
         bool deleted_; // flag that is set to true if delete_all() is called
+        RemoteCache* cache_; // copies of remote values read with get_cached, nullptr if disabled
+        SpillStore* spill_; // keeps local values within a memory budget, nullptr if disabled
+        RowerRegistry* rowers_; // the types of RemoteRower other nodes can run here
+        HashRing* ring_; // picks the node of the keys made with placed_key
 
         // constructs an empty KVStore
         KVStore(const char* addr);
 
+        // returns the shard that holds the given key
+        KVShard* shard_(Key* k);
+
         // deconstructor
         ~KVStore(); 
 
@@ -41,6 +303,11 @@ class KVStore : public Object {
         // this method should only be called by KVStore class
         void put(Key* k, DataFrame* v);
         
+        // returns a new key (owned by the caller) with the given string, whose node is picked by
+        // consistent hashing of the string instead of by the caller, so keys spread evenly over
+        // the nodes and every node picks the same one for the same string (see HashRing)
+        Key* placed_key(const char* str);
+
         // gets the DataFrame for the given Key
         // key index must match this index
         // returns nullptr if the key does not exist in this store
@@ -48,7 +315,179 @@ class KVStore : public Object {
 
         // waits until the given key is in this store, then returns the corresponding DataFrame
         DataFrame* wait_and_get(Key* k);
+
+        // starts a get of the given key and returns right away
+        // the returned future (owned by the caller) holds the DataFrame, or nullptr if the key does
+        // not exist, once it is ready - neither the key nor the future may be deleted before that
+        Future* get_async(Key* k);
+
+        // like get_async, but the future is only ready once the key exists
+        Future* wait_and_get_async(Key* k);
+
+        // completes the given future with the value of the given local key once it is put
+        // completes it immediately if the key is already in this store
+        void when_present(Key* k, Future* f);
+
+        // puts each of the n keys with the matching dataframe
+        // sends one message to each node that owns some of the keys
+        void put_many(Key** keys, DataFrame** vals, size_t n);
+
+        // gets the dataframe of each of the n keys into out, nullptr for keys that do not exist
+        // each node that owns some of the keys is asked once, and all of them are asked before
+        // any reply is awaited
+        void get_many(Key** keys, size_t n, DataFrame** out);
+
+        // like get_many, but waits until every key exists
+        void wait_and_get_many(Key** keys, size_t n, DataFrame** out);
        
+        // puts the given local key and dataframe here and, under the same key string with their
+        // own index, into the store of every other node
+        // the value is serialized once and passed down a binomial tree, so this node sends it
+        // about log2(nodes) times instead of once per node
+        void broadcast(Key* k, DataFrame* v);
+
+        // read replicas, for values that many nodes read (ex. lookup tables)
+        // the value of the given key is put on its node and the copies - 1 nodes after it (every
+        // node if copies is 0 or at least the number of nodes), each under the same key string
+        // with its own index, and the key and value stay owned by the caller
+        // every replica is sent once, and all of them by a broadcast if every node gets one
+        void put_replicated(Key* k, DataFrame* v, size_t copies);
+
+        // gets the value of the given key, put with put_replicated with the same number of copies,
+        // from the local replica if this node has one, else from one of the replicas picked by the
+        // index of this node, so the readers are spread evenly over the replicas
+        // as with get, a remote value is a copy owned by the caller and a local one is not
+        // NOTE: the replicas are put one by one, so a value that is put again may be read from a
+        // replica that does not have it yet - replicate values that are only put once
+        DataFrame* get_replicated(Key* k, size_t copies);
+
+        // like get_replicated, but waits until the replica it reads from has the key
+        DataFrame* wait_and_get_replicated(Key* k, size_t copies);
+
+        // returns the key of the replica of the given key that this node reads from (owned by the
+        // caller), see get_replicated
+        Key* replica_(Key* k, size_t copies);
+
+        // collectives: every node calls the same one with the same name (unique per call), and
+        // each passes its own value (not owned) - see Node for the algorithms
+        // a collective can be the last call before teardown: the network is only torn down once
+        // every node is deleted, and its last Collect messages are handled rather than dropped
+        // gathers the value of every node on the given root, returns an array of num nodes
+        // values (all owned by the caller) by node index on the root and nullptr elsewhere
+        DataFrame** gather(const char* name, DataFrame* v, int root);
+
+        // combines the value of every node with the given commutative operation on the given
+        // root, returns the result (owned by the caller) on the root and nullptr elsewhere
+        DataFrame* reduce(const char* name, MergeOp op, DataFrame* v, int root);
+
+        // combines the value of every node with the given commutative operation and returns the
+        // result (owned by the caller) on every node
+        DataFrame* allreduce(const char* name, MergeOp op, DataFrame* v);
+
+        // blocks until every node has called barrier() as many times as this node, without
+        // putting any keys (see Node::barrier)
+        void barrier();
+
+        // keeps local copies of the remote values read with get_cached and wait_and_get_cached
+        // the copies take up at most budget bytes, the least recently used are dropped first
+        void enable_cache(size_t budget);
+
+        // like get, but for a key whose value never changes once it is put
+        // a remote value is only fetched the first time, later calls get a copy from the cache
+        // (the returned DataFrame is owned by the caller, as with get)
+        DataFrame* get_cached(Key* k);
+
+        // like wait_and_get, but for a key whose value never changes once it is put
+        DataFrame* wait_and_get_cached(Key* k);
+
+        // drops the cached copy of the given key (ex. once the key is put again)
+        void invalidate(Key* k);
+
+        // keeps the local values within budget bytes of memory: once they take up more, the least
+        // recently used ones are written to files in dir and loaded back when they are used
+        // NOTE: with spilling on, a local DataFrame returned by get is only valid until the value
+        // is written out, so it should not be kept across later puts and gets
+        void enable_spill(size_t budget, const char* dir);
+
+        // applies the given operation to the value of the given key on the node that owns it (see
+        // MergeOp), atomically with respect to other merges, puts and gets of the key
+        // a remote merge is sent one way and does not wait for the owner
+        // neither the key nor v is kept, a key that does not exist gets a copy of v
+        void merge(Key* k, MergeOp op, DataFrame* v);
+
+        // applies the given operation to each of the n keys with the matching operand
+        // sends one message to each node that owns some of the keys, and does not wait for them
+        void merge_many(Key** keys, MergeOp op, DataFrame** vals, size_t n);
+
+        // adds the given number to the int counter stored at the given key (created if missing)
+        void increment(Key* k, int by);
+
+        // registers a type of RemoteRower under the given name, so other nodes can run it here
+        // every node registers the same types before any node executes them
+        void register_rower(const char* name, RowerFactory f);
+
+        // runs the given rower over the value of the given key on the node that owns it and
+        // returns its result (owned by the caller), or nullptr if the key does not exist
+        // only the state of the rower is sent to the owner and only the result comes back, the
+        // value does not move - the given rower itself is not run, it is copied from its state
+        // the owner runs the rowers it is asked for one at a time on a thread next to its
+        // listener, so they do not hold up its other messages but do wait for each other
+        DataFrame* execute(Key* k, RemoteRower& r);
+
+        // like execute, but returns right away, the returned future (owned by the caller) holds
+        // the result once it is ready, so the rowers of many keys can run at once
+        Future* execute_async(Key* k, RemoteRower& r);
+
+        // runs a rower of the type registered under the given name, made from the given state,
+        // over the value of the given local key and returns its result (owned by the caller)
+        DataFrame* run_local_(Key* k, const char* name, DataFrame* state);
+
+        // gets the value of the given local key for the listener, which must call release_ for the
+        // value once it is done with it (until then, the value is not deleted by a merge and
+        // stays in memory with spilling on, see KVShard and SpillStore)
+        DataFrame* get_local_(Key* k);
+
+        // releases the given value of the given local key got with get_local_ or by a future that
+        // pins its value (see Future::pin_)
+        void release_(Key* k, DataFrame* v);
+
+        // removes the given key from the node that owns it and deletes its value right away, so
+        // iterative jobs can free the values of earlier steps
+        // a remote remove is sent one way and does not wait for the owner
+        // a value the owner's listener is still sending is deleted once it is sent (see KVShard)
+        // NOTE: a local DataFrame returned by an earlier get is deleted too, so a key should only
+        // be removed once no node uses or reads its value (ex. after a barrier)
+        void remove(Key* k);
+
+        // removes each of the n keys, sends one message to each node that owns some of them
+        void remove_many(Key** keys, size_t n);
+
+        // removes every key that starts with the given prefix from every node (see remove)
+        // sends one message to each other node and does not wait for them
+        void remove_prefix(const char* prefix);
+
+        // removes the given local key and deletes its value, returns false if it is not here
+        bool remove_local_(Key* k);
+
+        // removes the local keys that start with the given prefix and deletes their values
+        // returns the number of keys removed
+        size_t remove_local_prefix_(const char* prefix);
+
+        // prefix scans: the keys of a node that start with a prefix are listed in order of their
+        // strings from the ordered index of each shard, in batches that continue after the last
+        // key string of the previous batch, so no batch walks the whole store (see KeyScan)
+        // adds copies (owned by the caller) of at most max of the local keys that start with the
+        // given prefix and come after the given key string (from the first if after is nullptr)
+        // to out, in order
+        void scan_local(const char* prefix, const char* after, size_t max,
+                std::vector<Key*>& out);
+
+        // starts a scan of at most max keys of the given node, like scan_local, and returns right
+        // away, the given future (not owned) holds the keys and, if values is true, their values
+        // once it is ready (see ScanFuture) - a batch of less than max keys is the last one
+        void scan_async(int node, const char* prefix, const char* after, size_t max, bool values,
+                ScanFuture* f);
+
         // gets the number of local keys in this KVStore
         size_t local_size();
 
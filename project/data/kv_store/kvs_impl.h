@@ -5,6 +5,7 @@
 #include "key.h"
 #include "kd_map.h"
 #include "kv_store.h"
+#include "spill.h"
 #include "../../util/object.h"
 #include "../../util/string.h"
 #include "../../util/helper.h"
@@ -19,18 +20,31 @@
 // per-node (per-application) KV Storage
 // constructs an empty KVStore
 KVStore::KVStore(const char* addr) {
-    kdm_ = new KDMap();
-    kdm_lock_ = new Lock();
+    shards_ = new KVShard*[KV_SHARDS];
+    for (size_t i = 0; i < KV_SHARDS; ++i) shards_[i] = new KVShard();
+    rowers_ = new RowerRegistry(); // before the node starts, it can be asked to run rowers
     node_ = new Node(addr, this);
     idx_ = node_->start();
+    ring_ = new HashRing(node_->num_nodes_, RING_VNODES);
     deleted_ = false;
+    cache_ = nullptr;
+    spill_ = nullptr;
 }
 
 // deconstructor
 KVStore::~KVStore() {
     delete node_;
-    delete kdm_;
-    delete kdm_lock_;
+    delete spill_; // removes the spill files that are left
+    for (size_t i = 0; i < KV_SHARDS; ++i) delete shards_[i];
+    delete[] shards_;
+    delete cache_;
+    delete rowers_;
+    delete ring_;
+}
+
+// returns the shard that holds the given key
+KVShard* KVStore::shard_(Key* k) {
+    return shards_[shard_index(k)];
 }
 
 // tears down entire KVStore
@@ -38,26 +52,23 @@ void KVStore::teardown() {
     node_->teardown_all();
 }
 
-// waits for the index to be set and then gets it
+// gets the index of this KVStore
+// the index is known once the constructor returns, since the node registers with the server there
 int KVStore::get_idx() {
-    if (idx_ >= 0) return idx_;
-    else {
-        while (idx_ < 0) kdm_lock_->wait();
-        kdm_lock_->unlock();
-        return idx_;
-    }
+    return idx_;
 }
 
 // puts the given Key and DataFrame into this KVStore
 // this method should only be called by KVStore class
 void KVStore::put(Key* k, DataFrame* v) {
     if (k->idx_ != idx_) node_->put(k, v);
-    else {
-        kdm_lock_->lock();
-        kdm_->put(k, v);
-        kdm_lock_->unlock();
-        kdm_lock_->notify_all();
-    }
+    else if (spill_ != nullptr) spill_->put(k, v);
+    else shard_(k)->put(k, v);
+}
+
+// returns a new key with the given string on the node picked by the hash ring
+Key* KVStore::placed_key(const char* str) {
+    return new Key(str, ring_->owner(str));
 }
 
 // gets the DataFrame for the given Key
@@ -65,42 +76,318 @@ void KVStore::put(Key* k, DataFrame* v) {
 DataFrame* KVStore::get(Key* k) {
     // call node get if index does not match this node's index
     if (k->idx_ != idx_) return node_->get(k);
-    else {    
-        kdm_lock_->lock();
-        DataFrame* out = kdm_->get(k);
-        kdm_lock_->unlock();
-        return out;
-    }
+    else if (spill_ != nullptr) return spill_->get(k);
+    else return shard_(k)->get(k);
 }
 
 // waits until the given key is in this store, then returns the corresponding DataFrame
 DataFrame* KVStore::wait_and_get(Key* k) {
     check(! deleted_, "All keys and vals were deleted_");
     if (k->idx_ != idx_) return node_->wait_and_get(k);
-    else {
-        kdm_lock_->lock();
-        while(! kdm_->contains_key(k)) {
-            // once the wait finishes, lock is acquired
-            // gets notified every put
-            kdm_lock_->wait();
-        }
-        kdm_lock_->unlock();
-        DataFrame* out = get(k);
-        // needs to unlock since wait acquires lock
-        return out;
+    else if (spill_ != nullptr) return spill_->wait_and_get(k);
+    else return shard_(k)->wait_and_get(k);
+}
+
+// starts a get of the given key, the returned future holds the DataFrame once it is ready
+Future* KVStore::get_async(Key* k) {
+    Future* out = new Future();
+    node_->get_async(k, out);
+    return out;
+}
+
+// starts a wait for the given key, the returned future holds the DataFrame once it is ready
+Future* KVStore::wait_and_get_async(Key* k) {
+    check(! deleted_, "All keys and vals were deleted_");
+    Future* out = new Future();
+    node_->wait_and_get_async(k, out);
+    return out;
+}
+
+// completes the given future with the value of the given local key once it is put
+void KVStore::when_present(Key* k, Future* f) {
+    check(k->idx_ == idx_, "KVStore: Key is not local");
+    if (spill_ != nullptr) spill_->when_present(k, f);
+    else shard_(k)->when_present(k, f);
+}
+
+// puts each of the n keys with the matching dataframe
+void KVStore::put_many(Key** keys, DataFrame** vals, size_t n) {
+    node_->put_many(keys, vals, n);
+}
+
+// gets the dataframe of each of the n keys into out, nullptr for keys that do not exist
+void KVStore::get_many(Key** keys, size_t n, DataFrame** out) {
+    node_->get_many(keys, n, out, false);
+}
+
+// gets the dataframe of each of the n keys into out, waiting until every key exists
+void KVStore::wait_and_get_many(Key** keys, size_t n, DataFrame** out) {
+    check(! deleted_, "All keys and vals were deleted_");
+    node_->get_many(keys, n, out, true);
+}
+
+// puts the given local key and dataframe into the store of every node, each under its own index
+void KVStore::broadcast(Key* k, DataFrame* v) {
+    node_->broadcast(k, v);
+}
+
+// puts the given value on the node of the given key and the copies - 1 nodes after it
+void KVStore::put_replicated(Key* k, DataFrame* v, size_t copies) {
+    size_t n = node_->num_nodes_;
+    if (copies == 0 || copies > n) copies = n;
+    if (copies == n && k->idx_ == idx_) {
+        node_->broadcast(new Key(k->str_, idx_), v->clone()); // stored locally
+        return;
+    }
+    Key** keys = new Key*[copies];
+    DataFrame** vals = new DataFrame*[copies];
+    for (size_t i = 0; i < copies; ++i) {
+        int to = (k->idx_ + i) % n;
+        keys[i] = new Key(k->str_, to);
+        vals[i] = to == idx_ ? v->clone() : v; // the local replica is stored, the rest are sent
+    }
+    put_many(keys, vals, copies);
+    for (size_t i = 0; i < copies; ++i) if (keys[i]->idx_ != idx_) delete keys[i];
+    delete[] keys;
+    delete[] vals;
+}
+
+// gets the value of the given key from the local replica or the one this node reads from
+DataFrame* KVStore::get_replicated(Key* k, size_t copies) {
+    Key* r = replica_(k, copies);
+    DataFrame* out = get(r);
+    delete r;
+    return out;
+}
+
+// waits for the value of the given key in the local replica or the one this node reads from
+DataFrame* KVStore::wait_and_get_replicated(Key* k, size_t copies) {
+    Key* r = replica_(k, copies);
+    DataFrame* out = wait_and_get(r);
+    delete r;
+    return out;
+}
+
+// returns the key of the replica of the given key this node reads from
+// the replicas are on the nodes k->idx_, ..., k->idx_ + copies - 1 (wrapping around)
+Key* KVStore::replica_(Key* k, size_t copies) {
+    size_t n = node_->num_nodes_;
+    if (copies == 0 || copies > n) copies = n;
+    size_t after = (idx_ - k->idx_ + n) % n; // how many nodes after the key's node this one is
+    if (after < copies) return new Key(k->str_, idx_);
+    return new Key(k->str_, (k->idx_ + idx_ % copies) % n);
+}
+
+// gathers the value of every node on the given root
+DataFrame** KVStore::gather(const char* name, DataFrame* v, int root) {
+    return node_->gather(name, v, root);
+}
+
+// combines the value of every node with the given operation on the given root
+DataFrame* KVStore::reduce(const char* name, MergeOp op, DataFrame* v, int root) {
+    return node_->reduce(name, op, v, root);
+}
+
+// combines the value of every node with the given operation on every node
+DataFrame* KVStore::allreduce(const char* name, MergeOp op, DataFrame* v) {
+    return node_->allreduce(name, op, v);
+}
+
+// blocks until every node has reached the same barrier
+void KVStore::barrier() {
+    node_->barrier();
+}
+
+// keeps local copies of the remote values read with get_cached and wait_and_get_cached
+void KVStore::enable_cache(size_t budget) {
+    check(cache_ == nullptr, "KVStore: Cache already enabled");
+    cache_ = new RemoteCache(budget);
+}
+
+// gets the DataFrame for a key whose value never changes, remote values are cached
+DataFrame* KVStore::get_cached(Key* k) {
+    if (k->idx_ == idx_ || cache_ == nullptr) return get(k);
+    DataFrame* out = cache_->get(k);
+    if (out != nullptr) return out;
+    out = get(k);
+    if (out != nullptr) cache_->put(k, out); // a missing key may still be put later
+    return out;
+}
+
+// waits for a key whose value never changes, remote values are cached
+DataFrame* KVStore::wait_and_get_cached(Key* k) {
+    if (k->idx_ == idx_ || cache_ == nullptr) return wait_and_get(k);
+    DataFrame* out = cache_->get(k);
+    if (out != nullptr) return out;
+    out = wait_and_get(k);
+    cache_->put(k, out);
+    return out;
+}
+
+// drops the cached copy of the given key
+void KVStore::invalidate(Key* k) {
+    if (cache_ != nullptr) cache_->invalidate(k);
+}
+
+// applies the given operation to the value of the given key on the node that owns it
+void KVStore::merge(Key* k, MergeOp op, DataFrame* v) {
+    if (k->idx_ != idx_) node_->merge_many(&k, op, &v, 1);
+    else if (spill_ != nullptr) spill_->merge(k, op, v);
+    else shard_(k)->merge(k, op, v);
+}
+
+// applies the given operation to each of the n keys with the matching operand
+void KVStore::merge_many(Key** keys, MergeOp op, DataFrame** vals, size_t n) {
+    node_->merge_many(keys, op, vals, n);
+}
+
+// adds the given number to the int counter stored at the given key
+void KVStore::increment(Key* k, int by) {
+    DataFrame* v = DataFrame::from_scalar(by);
+    merge(k, MergeOp::Add, v);
+    delete v;
+}
+
+// registers a type of RemoteRower under the given name
+void KVStore::register_rower(const char* name, RowerFactory f) {
+    rowers_->add(name, f);
+}
+
+// runs the given rower over the value of the given key on the node that owns it
+DataFrame* KVStore::execute(Key* k, RemoteRower& r) {
+    Future* f = execute_async(k, r);
+    DataFrame* out = f->get();
+    delete f;
+    return out;
+}
+
+// starts running the given rower on the node that owns the given key
+Future* KVStore::execute_async(Key* k, RemoteRower& r) {
+    Future* out = new Future();
+    DataFrame* state = r.state();
+    if (k->idx_ == idx_) out->complete(run_local_(k, r.name(), state));
+    else node_->execute_async(k, r.name(), state, out);
+    delete state;
+    return out;
+}
+
+// runs a registered rower made from the given state over the value of the given local key
+DataFrame* KVStore::run_local_(Key* k, const char* name, DataFrame* state) {
+    RemoteRower* r = rowers_->make(name, state);
+    DataFrame* v = get_local_(k);
+    DataFrame* out = run_rower(r, v);
+    if (v != nullptr) release_(k, v);
+    delete r;
+    return out;
+}
+
+// gets the value of the given local key, pinned until release_
+DataFrame* KVStore::get_local_(Key* k) {
+    check(k->idx_ == idx_, "KVStore: Key is not local");
+    if (spill_ != nullptr) return spill_->get(k, true);
+    else return shard_(k)->get(k, true);
+}
+
+// releases a pin of the given value of the given local key
+void KVStore::release_(Key* k, DataFrame* v) {
+    if (spill_ != nullptr) spill_->release(k, v);
+    else shard_(k)->release(v);
+}
+
+// removes the given key from the node that owns it and deletes its value
+void KVStore::remove(Key* k) {
+    remove_many(&k, 1);
+}
+
+// removes each of the n keys from the node that owns it
+void KVStore::remove_many(Key** keys, size_t n) {
+    for (size_t i = 0; i < n; ++i) invalidate(keys[i]);
+    node_->remove_many(keys, n, false);
+}
+
+// removes every key that starts with the given prefix from every node
+void KVStore::remove_prefix(const char* prefix) {
+    if (cache_ != nullptr) cache_->invalidate_prefix(prefix);
+    size_t n = node_->num_nodes_;
+    Key** keys = new Key*[n];
+    for (size_t i = 0; i < n; ++i) keys[i] = new Key(prefix, i);
+    node_->remove_many(keys, n, true);
+    for (size_t i = 0; i < n; ++i) delete keys[i];
+    delete[] keys;
+}
+
+// removes the given local key and deletes its value, once it is released if it is pinned
+bool KVStore::remove_local_(Key* k) {
+    check(k->idx_ == idx_, "KVStore: Key is not local");
+    if (spill_ != nullptr) return spill_->remove(k);
+    Key* stored = nullptr;
+    DataFrame* df = shard_(k)->remove(k, &stored);
+    bool out = df != nullptr;
+    delete stored;
+    if (out) shard_(k)->drop(df);
+    return out;
+}
+
+// removes the local keys that start with the given prefix and deletes their values
+size_t KVStore::remove_local_prefix_(const char* prefix) {
+    std::vector<Key*> keys;
+    for (size_t i = 0; i < KV_SHARDS; ++i) shards_[i]->keys_with_prefix(prefix, keys);
+    if (spill_ != nullptr) spill_->spilled_with_prefix(prefix, keys);
+    size_t out = 0;
+    for (Key* k : keys) {
+        if (remove_local_(k)) ++out;
+        delete k;
+    }
+    return out;
+}
+
+// adds copies of at most max of the local keys that start with the given prefix and come after
+// the given key string to out, in order
+void KVStore::scan_local(const char* prefix, const char* after, size_t max,
+        std::vector<Key*>& out) {
+    // the spill store holds its lock, so no key moves between a shard and a file during the scan
+    if (spill_ != nullptr) spill_->scan(prefix, after, max, out);
+    else scan_shards(shards_, prefix, after, max, out);
+}
+
+// starts a scan of at most max keys of the given node, the given future holds them once ready
+void KVStore::scan_async(int node, const char* prefix, const char* after, size_t max,
+        bool values, ScanFuture* f) {
+    check(node >= 0 && (size_t)node < node_->num_nodes_, "KVStore: Index out of bounds");
+    if (node == idx_) {
+        scan_local(prefix, after, max, f->keys_);
+        for (Key* k : f->keys_) f->vals_.push_back(values ? get(k) : nullptr);
+        f->complete(nullptr);
+        return;
     }
+    Key p(prefix, node);
+    Key* a = after == nullptr ? nullptr : new Key(after, node);
+    node_->scan_async(&p, a, max, values, f);
+    delete a;
+}
+
+// keeps the local values within budget bytes of memory, spilling the rest to files in dir
+void KVStore::enable_spill(size_t budget, const char* dir) {
+    check(spill_ == nullptr, "KVStore: Spilling already enabled");
+    spill_ = new SpillStore(shards_, budget, dir, idx_);
 }
 
 // gets the number of local keys in this KVStore
 size_t KVStore::local_size() {
-    kdm_lock_->lock();
-    size_t out = kdm_->size();
-    kdm_lock_->unlock();
+    size_t out = 0;
+    for (size_t i = 0; i < KV_SHARDS; ++i) out += shards_[i]->size();
+    if (spill_ != nullptr) out += spill_->spilled(); // spilled values are not in the shards
     return out;
 }
 
 // deletes all the keys and values in the whole KVStore (not just for this node's store
 void KVStore::delete_all() {
-    if (! deleted_) kdm_->delete_all();
+    if (! deleted_) {
+        for (size_t i = 0; i < KV_SHARDS; ++i) {
+            shards_[i]->kdm_->delete_all();
+            shards_[i]->delete_retired();
+        }
+        if (spill_ != nullptr) spill_->delete_all();
+    }
     deleted_ = 1;
 }
@@ -0,0 +1,142 @@
+// Authors: Zoe Corning(corning.z@husky.neu.edu) & Rucha Khanolkar(khanolkar.r@husky.neu.edu)
+
+#pragma once
+
+#include "key.h"
+#include "../../util/object.h"
+#include "../../util/helper.h"
+
+// an entry of an LruTable, subclasses add the data that goes with the key
+class LruEntry : public Object {
+    public:
+        Key* key_; // owned copy of the key
+        size_t bytes_; // memory the entry stands for, summed up in LruTable::used_
+        LruEntry* prev_; // more recently used entry (nullptr for the most recent)
+        LruEntry* next_; // less recently used entry (nullptr for the least recent)
+        LruEntry* chain_; // next entry in the same bucket
+
+        // copies the given key
+        LruEntry(Key* k, size_t bytes) : Object() {
+            key_ = new Key(k->str_, k->idx_);
+            bytes_ = bytes;
+            prev_ = nullptr;
+            next_ = nullptr;
+            chain_ = nullptr;
+        }
+
+        virtual ~LruEntry() {
+            delete key_;
+        }
+};
+
+// entries looked up by key and ordered from most to least recently used
+// entries are chained through LruEntry::chain_ in a power of 2 number of buckets picked by key
+// hash, and linked through prev_/next_ in the order they were last used
+// not thread safe, the owner guards it with its own lock
+class LruTable : public Object {
+    public:
+        size_t size_; // number of entries
+        size_t used_; // sum of the bytes_ of the entries
+        size_t cap_; // number of buckets, always a power of 2
+        LruEntry** buckets_;
+        LruEntry* head_; // most recently used entry
+        LruEntry* tail_; // least recently used entry
+
+        LruTable() : Object() {
+            size_ = 0;
+            used_ = 0;
+            cap_ = 16;
+            buckets_ = new LruEntry*[cap_];
+            memset(buckets_, 0, cap_ * sizeof(LruEntry*));
+            head_ = nullptr;
+            tail_ = nullptr;
+        }
+
+        // deletes every entry
+        ~LruTable() {
+            while (head_ != nullptr) delete take(head_->key_);
+            delete[] buckets_;
+        }
+
+        // returns the entry of the given key, or nullptr if there is none
+        LruEntry* get(Key* k) { return *find_(k); }
+
+        // adds the given entry (owned) as the most recently used one
+        // @pre there is no entry with the same key
+        void add(LruEntry* e) {
+            if (size_ + 1 > cap_) grow_();
+            LruEntry** b = &buckets_[e->key_->hash() & (cap_ - 1)];
+            e->chain_ = *b;
+            *b = e;
+            push_front_(e);
+            used_ += e->bytes_;
+            ++size_;
+        }
+
+        // makes the given entry the most recently used one
+        void touch(LruEntry* e) {
+            unlink_(e);
+            push_front_(e);
+        }
+
+        // removes the entry of the given key and returns it (now owned by the caller)
+        // returns nullptr if there is none
+        LruEntry* take(Key* k) {
+            LruEntry** slot = find_(k);
+            LruEntry* e = *slot;
+            if (e == nullptr) return nullptr;
+            *slot = e->chain_;
+            e->chain_ = nullptr;
+            unlink_(e);
+            used_ -= e->bytes_;
+            --size_;
+            return e;
+        }
+
+        // returns the slot that points to the entry of the given key (the slot holds nullptr if
+        // there is no such entry)
+        LruEntry** find_(Key* k) {
+            LruEntry** cur = &buckets_[k->hash() & (cap_ - 1)];
+            while (*cur != nullptr && !(*cur)->key_->equals(k)) cur = &(*cur)->chain_;
+            return cur;
+        }
+
+        // takes the given entry out of the recently used list
+        void unlink_(LruEntry* e) {
+            if (e->prev_ != nullptr) e->prev_->next_ = e->next_;
+            else head_ = e->next_;
+            if (e->next_ != nullptr) e->next_->prev_ = e->prev_;
+            else tail_ = e->prev_;
+            e->prev_ = nullptr;
+            e->next_ = nullptr;
+        }
+
+        // puts the given entry at the front of the recently used list
+        void push_front_(LruEntry* e) {
+            e->prev_ = nullptr;
+            e->next_ = head_;
+            if (head_ != nullptr) head_->prev_ = e;
+            head_ = e;
+            if (tail_ == nullptr) tail_ = e;
+        }
+
+        // doubles the number of buckets
+        void grow_() {
+            size_t old_cap = cap_;
+            LruEntry** old = buckets_;
+            cap_ *= 2;
+            buckets_ = new LruEntry*[cap_];
+            memset(buckets_, 0, cap_ * sizeof(LruEntry*));
+            for (size_t i = 0; i < old_cap; ++i) {
+                LruEntry* e = old[i];
+                while (e != nullptr) {
+                    LruEntry* next = e->chain_;
+                    LruEntry** b = &buckets_[e->key_->hash() & (cap_ - 1)];
+                    e->chain_ = *b;
+                    *b = e;
+                    e = next;
+                }
+            }
+            delete[] old;
+        }
+};
@@ -0,0 +1,107 @@
+// Authors: Zoe Corning(corning.z@husky.neu.edu) & Rucha Khanolkar(khanolkar.r@husky.neu.edu)
+
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include "../../util/helper.h"
+#include "../../util/string.h"
+#include "../dataframe/dataframe.h"
+
+// read-modify-write operations a KVStore applies to a stored value on the node that owns it
+//   Add    -> adds each int/float cell of the operand to the same cell of the value (counters)
+//   Append -> adds the rows of the operand to the end of the value
+//   Or     -> ORs each bool cell of the operand into the same cell of the value (bitmap sets)
+//   Min    -> keeps the smaller of each int/float cell of the value and the operand
+//   Max    -> keeps the bigger of each int/float cell of the value and the operand
+//   Union  -> treats the value and the operand as sets of ints (one int column, one element per
+//             row) and adds the elements of the operand that the value does not have yet
+// a key that does not exist yet gets a copy of the operand as its value
+enum class MergeOp { Add, Append, Or, Min, Max, Union };
+
+// number of merge operations, used to check deserialized ops
+const size_t MERGE_OPS = 6;
+
+// returns true if the given operation adds rows to the value, which moves the cells it already
+// has, rather than only changing them
+bool changes_rows(MergeOp op) { return op == MergeOp::Append || op == MergeOp::Union; }
+
+// checks that the given dataframes have the same column types
+void check_same_types_(DataFrame* a, DataFrame* b) {
+    check(a->ncols() == b->ncols(), "Merge: Mismatched number of columns");
+    for (size_t i = 0; i < a->ncols(); ++i) {
+        check(a->get_schema().col_type(i) == b->get_schema().col_type(i), "Merge: Mismatched types");
+    }
+}
+
+// adds the elements of the given int set that are not in the given int set to it (MergeOp::Union)
+void union_into_(DataFrame* into, DataFrame* v) {
+    check(into->ncols() == 1 && into->get_schema().col_type(0) == 'I',
+            "Merge: Union needs one int column");
+    std::vector<int> have(into->nrows());
+    for (size_t r = 0; r < have.size(); ++r) have[r] = into->get_int(0, r);
+    std::sort(have.begin(), have.end());
+    std::vector<int> add(v->nrows());
+    for (size_t r = 0; r < add.size(); ++r) add[r] = v->get_int(0, r);
+    std::sort(add.begin(), add.end());
+    add.erase(std::unique(add.begin(), add.end()), add.end());
+
+    Column* to = into->get_col_(0);
+    for (int e : add) {
+        if (std::binary_search(have.begin(), have.end(), e)) continue;
+        to->push_back(e);
+        into->get_schema().add_row();
+    }
+}
+
+// applies the given operation to the given value with the given operand (see MergeOp)
+// the value is changed in place, the operand is not changed or kept
+void merge_into(MergeOp op, DataFrame* into, DataFrame* v) {
+    check_same_types_(into, v);
+    size_t n = v->nrows();
+    if (op == MergeOp::Append) {
+        for (size_t i = 0; i < v->ncols(); ++i) {
+            Column* from = v->get_col_(i);
+            Column* to = into->get_col_(i);
+            char type = from->get_type();
+            for (size_t r = 0; r < n; ++r) {
+                if (type == 'B') to->push_back(from->as_bool()->get(r));
+                else if (type == 'I') to->push_back(from->as_int()->get(r));
+                else if (type == 'F') to->push_back(from->as_float()->get(r));
+                else {
+                    String* str = from->as_string()->get(r);
+                    to->push_back(str == nullptr ? nullptr : str->clone());
+                }
+            }
+        }
+        for (size_t r = 0; r < n; ++r) into->get_schema().add_row();
+        return;
+    }
+    if (op == MergeOp::Union) {
+        union_into_(into, v);
+        return;
+    }
+
+    check(into->nrows() == n, "Merge: Mismatched number of rows");
+    for (size_t i = 0; i < v->ncols(); ++i) {
+        char type = v->get_schema().col_type(i);
+        for (size_t r = 0; r < n; ++r) {
+            if (op == MergeOp::Add && type == 'I') {
+                into->set(i, r, into->get_int(i, r) + v->get_int(i, r));
+            } else if (op == MergeOp::Add && type == 'F') {
+                into->set(i, r, into->get_float(i, r) + v->get_float(i, r));
+            } else if (op == MergeOp::Min && type == 'I') {
+                into->set(i, r, std::min(into->get_int(i, r), v->get_int(i, r)));
+            } else if (op == MergeOp::Min && type == 'F') {
+                into->set(i, r, std::min(into->get_float(i, r), v->get_float(i, r)));
+            } else if (op == MergeOp::Max && type == 'I') {
+                into->set(i, r, std::max(into->get_int(i, r), v->get_int(i, r)));
+            } else if (op == MergeOp::Max && type == 'F') {
+                into->set(i, r, std::max(into->get_float(i, r), v->get_float(i, r)));
+            } else if (op == MergeOp::Or && type == 'B') {
+                bool b = into->get_bool(i, r) || v->get_bool(i, r);
+                into->set(i, r, b);
+            } else check(false, "Merge: Operation does not apply to column type");
+        }
+    }
+}
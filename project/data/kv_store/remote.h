@@ -0,0 +1,101 @@
+// Authors: Zoe Corning(corning.z@husky.neu.edu) & Rucha Khanolkar(khanolkar.r@husky.neu.edu)
+
+#pragma once
+
+#include <vector>
+#include "../../util/object.h"
+#include "../../util/string.h"
+#include "../../util/helper.h"
+#include "../../util/thread.h"
+#include "../dataframe/dataframe.h"
+#include "../dataframe/rower.h"
+
+// a Rower that can run on the node that stores a DataFrame instead of on the node that wants
+// the result, so only its state and its result go over the network
+// its type is registered under name() with a RowerRegistry on every node, and state() is enough
+// for the factory of that name to make an equal rower on another node
+class RemoteRower : public Rower {
+    public:
+        // returns the name this type of rower is registered under
+        virtual const char* name() {
+            check(false, "Called in parent");
+            return nullptr;
+        }
+
+        // returns the state this rower is made from (owned by the caller), sent to the owner of
+        // the DataFrame it runs over
+        virtual DataFrame* state() {
+            check(false, "Called in parent");
+            return nullptr;
+        }
+
+        // returns the result of the rows accepted so far (owned by the caller), sent back once the
+        // rower has visited every row
+        virtual DataFrame* result() {
+            check(false, "Called in parent");
+            return nullptr;
+        }
+};
+
+// makes a rower of one registered type from the given state (not owned)
+typedef RemoteRower* (*RowerFactory)(DataFrame* state);
+
+// the types of RemoteRower a node can run, by name
+// every node registers the same types before any node asks another one to run them
+// thread safe
+class RowerRegistry : public Object {
+    public:
+        std::vector<char*> names_; // owned
+        std::vector<RowerFactory> factories_; // factory of the type with the same index in names_
+        Lock lock_; // guards names_ and factories_
+
+        ~RowerRegistry() {
+            for (char* n : names_) delete[] n;
+        }
+
+        // registers the given factory under the given name
+        // a name is sent as one token of a message, so it may not hold spaces, braces or bars
+        void add(const char* name, RowerFactory f) {
+            check(name[0] != '\0' && strpbrk(name, " {}|\\\n") == nullptr,
+                    "RowerRegistry: Invalid name");
+            lock_.lock();
+            check(find_(name) < 0, "RowerRegistry: Name already registered");
+            names_.push_back(duplicate(name));
+            factories_.push_back(f);
+            lock_.unlock();
+        }
+
+        // returns true if a type is registered under the given name
+        bool has(const char* name) {
+            lock_.lock();
+            bool out = find_(name) >= 0;
+            lock_.unlock();
+            return out;
+        }
+
+        // makes a rower of the type registered under the given name from the given state
+        // (not owned), the rower is owned by the caller
+        RemoteRower* make(const char* name, DataFrame* state) {
+            lock_.lock();
+            int i = find_(name);
+            RowerFactory f = i < 0 ? nullptr : factories_[i];
+            lock_.unlock();
+            check(f != nullptr, "RowerRegistry: Name not registered");
+            return f(state);
+        }
+
+        // returns the index of the given name, -1 if it is not registered
+        // @pre the lock is held
+        int find_(const char* name) {
+            for (size_t i = 0; i < names_.size(); ++i) if (streq(names_[i], name)) return i;
+            return -1;
+        }
+};
+
+// runs the given rower over the given dataframe and returns its result (owned by the caller)
+// the dataframe may be nullptr (a missing key), then the result is nullptr too
+DataFrame* run_rower(RemoteRower* r, DataFrame* df) {
+    if (df == nullptr) return nullptr;
+    df->map(*r);
+    return r->result();
+}
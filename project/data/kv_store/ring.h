@@ -0,0 +1,58 @@
+// Authors: Zoe Corning(corning.z@husky.neu.edu) & Rucha Khanolkar(khanolkar.r@husky.neu.edu)
+
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include "../../util/object.h"
+#include "../../util/helper.h"
+
+const size_t RING_VNODES = 256; // default number of points of each node on a HashRing
+const uint64_t RING_SEED = 0x9e3779b97f4a7c15ULL; // seed of the hashes of the strings placed
+
+// picks the node of a key string by consistent hashing
+// each node has vnodes_ points at pseudo random positions on a ring of 64 bit hashes, and a
+// string belongs to the node of the first point at or after the hash of the string (wrapping
+// around), so every node gets about 1 / nodes of the strings
+// the points of a node do not depend on the number of nodes, so a ring with one more node only
+// moves the strings that land just before the new node's points (about 1 / (nodes + 1) of
+// them), all to the new node
+// every node builds the same ring from the same number of nodes, with no messages
+class HashRing : public Object {
+    public:
+        size_t nodes_; // number of nodes, indexed from 0
+        size_t vnodes_; // number of points of each node
+        std::vector<uint64_t> points_; // position of every point, sorted
+        std::vector<int> owners_; // node of the point with the same index in points_
+
+        // builds the ring of the given number of nodes, each with the given number of points
+        HashRing(size_t nodes, size_t vnodes) : Object() {
+            check(nodes > 0 && vnodes > 0, "HashRing: Needs at least one point");
+            nodes_ = nodes;
+            vnodes_ = vnodes;
+            std::vector<std::pair<uint64_t, int>> all;
+            all.reserve(nodes * vnodes);
+            for (size_t n = 0; n < nodes; ++n) {
+                for (size_t v = 0; v < vnodes; ++v) all.push_back({point_(n, v), (int)n});
+            }
+            std::sort(all.begin(), all.end());
+            points_.reserve(all.size());
+            owners_.reserve(all.size());
+            for (auto& p : all) {
+                points_.push_back(p.first);
+                owners_.push_back(p.second);
+            }
+        }
+
+        // returns the position of the given point of the given node
+        static uint64_t point_(size_t node, size_t v) { return mix64((node << 32 | v) + 1); }
+
+        // returns the node of the given string
+        int owner(const char* str, size_t len) {
+            uint64_t h = hash_bytes(str, len, RING_SEED);
+            size_t i = std::lower_bound(points_.begin(), points_.end(), h) - points_.begin();
+            return owners_[i == points_.size() ? 0 : i];
+        }
+
+        int owner(const char* str) { return owner(str, strlen(str)); }
+};
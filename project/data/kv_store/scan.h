@@ -0,0 +1,110 @@
+// Authors: Zoe Corning(corning.z@husky.neu.edu) & Rucha Khanolkar(khanolkar.r@husky.neu.edu)
+
+#pragma once
+
+#include "key.h"
+#include "future.h"
+#include "kvs_impl.h"
+#include "../../util/object.h"
+#include "../../util/string.h"
+#include "../../util/helper.h"
+#include "../dataframe/dataframe.h"
+
+// lists the keys that start with a prefix, and their values if asked for, on one node or on
+// every node, in batches of at most batch_ keys
+// each batch continues after the last key string of the batch before it, so a node sends each of
+// its keys once even if they do not fit in one message, and it finds them in its ordered indexes
+// instead of walking its tables
+// the keys of a node come in order of their strings, and the nodes in order of their index
+// the next batch from another node is asked for as soon as a batch is handed out, so it is on its
+// way while the caller works on the current one
+// a key that is put or removed during the scan may or may not be listed
+class KeyScan : public Object {
+    public:
+        KVStore* kvs_; // not owned
+        char* prefix_; // owned
+        size_t batch_; // most keys in a batch
+        bool values_; // true if the values are listed too
+        int node_; // node of the next batch
+        int last_; // last node to scan
+        char* after_; // owned, last key string of the batch before the next one, nullptr if none
+        ScanFuture* cur_; // owned, the batch handed out by the last call to next()
+        ScanFuture* ahead_; // owned, the next batch if it has been asked for already
+
+        // scans the keys of the given node, or of every node if node is -1
+        KeyScan(KVStore* kvs, const char* prefix, size_t batch, bool values, int node = -1)
+                : Object() {
+            check(batch > 0, "KeyScan: Batch size must be positive");
+            kvs_ = kvs;
+            prefix_ = duplicate(prefix);
+            batch_ = batch;
+            values_ = values;
+            node_ = node < 0 ? 0 : node;
+            last_ = node < 0 ? kvs->node_->num_nodes_ - 1 : node;
+            after_ = nullptr;
+            cur_ = nullptr;
+            ahead_ = nullptr;
+        }
+
+        // waits for the batch that was asked for, since the listener completes it
+        ~KeyScan() {
+            if (ahead_ != nullptr) ahead_->get();
+            delete ahead_;
+            delete cur_;
+            delete[] after_;
+            delete[] prefix_;
+        }
+
+        // moves on to the next batch that holds keys, returns false once every key is listed
+        // the keys and values of the batch before are deleted, if they are owned by the scan
+        bool next() {
+            delete cur_;
+            cur_ = nullptr;
+            while (node_ <= last_) {
+                if (ahead_ == nullptr) ahead_ = request_();
+                ScanFuture* got = ahead_;
+                ahead_ = nullptr;
+                got->get();
+
+                // a full batch may be followed by more keys of the same node
+                delete[] after_;
+                after_ = nullptr;
+                if (got->keys_.size() == batch_) after_ = duplicate(got->keys_.back()->str_);
+                else ++node_;
+                // a local batch is only listed once it is needed, since with spilling on its
+                // values could push the values of the current batch out of memory
+                if (node_ <= last_ && node_ != kvs_->idx_) ahead_ = request_();
+
+                if (! got->keys_.empty()) {
+                    cur_ = got;
+                    return true;
+                }
+                delete got;
+            }
+            return false;
+        }
+
+        // returns the number of keys in the current batch
+        size_t size() { return cur_ == nullptr ? 0 : cur_->keys_.size(); }
+
+        // returns the key at the given index of the current batch (owned by the scan)
+        Key* key(size_t i) {
+            check(i < size(), "KeyScan: Index out of bounds");
+            return cur_->keys_[i];
+        }
+
+        // returns the value of the key at the given index of the current batch, nullptr if values
+        // were not asked for or the key was removed during the scan
+        // a remote value is owned by the scan, a local one is the one in the store (as with get)
+        DataFrame* value(size_t i) {
+            check(i < size(), "KeyScan: Index out of bounds");
+            return cur_->vals_[i];
+        }
+
+        // asks for the next batch and returns its future (owned by the caller)
+        ScanFuture* request_() {
+            ScanFuture* out = new ScanFuture();
+            kvs_->scan_async(node_, prefix_, after_, batch_, values_, out);
+            return out;
+        }
+};
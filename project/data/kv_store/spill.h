@@ -0,0 +1,302 @@
+// Authors: Zoe Corning(corning.z@husky.neu.edu) & Rucha Khanolkar(khanolkar.r@husky.neu.edu)
+
+#pragma once
+
+#include <stdio.h>
+#include <vector>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "key.h"
+#include "key_index.h"
+#include "lru.h"
+#include "future.h"
+#include "kv_store.h"
+#include "../../util/object.h"
+#include "../../util/helper.h"
+#include "../../util/thread.h"
+#include "../dataframe/dataframe.h"
+#include "../dataframe/binary.h"
+
+// a value of a SpillStore that has been written to a file
+class SpillEntry : public LruEntry {
+    public:
+        Key* stored_; // owned, the key the shard held for the value, put back when it is loaded
+        char* path_; // owned, the file the value is in
+
+        // takes ownership of the given stored key and path
+        SpillEntry(Key* stored, char* path) : LruEntry(stored, 0) {
+            stored_ = stored;
+            path_ = path;
+        }
+
+        ~SpillEntry() {
+            delete[] path_;
+        }
+};
+
+// keeps the local values of a KVStore within a memory budget
+// when the values in memory take up more than budget_ bytes, the least recently used ones are
+// written to files in dir_ (in the binary format of binary.h) and taken out of their shard, and a
+// get of a value that was written out loads it back into its shard
+// every put, get and wait goes through the lock of this store, so the recently used order stays
+// exact while spilling is on, but futures are completed after the lock is released, since they
+// may send replies
+// a value can be pinned (see get and Future::pin_): the pins are kept by its shard, and it is not
+// written out until every pin is released, so the listener can serialize it after the lock is
+// released
+// NOTE: a value that is written out is deleted, so a DataFrame returned by a get that does not pin
+// it is only valid until the value becomes the least recently used one and is spilled
+class SpillStore : public Object {
+    public:
+        KVShard** shards_; // not owned, the shards of the store the values are in
+        size_t budget_; // most bytes the values in memory can take up
+        char* dir_; // owned, directory the spill files are written to
+        int idx_; // index of the node, part of the name of each spill file
+        size_t files_; // number of spill files written so far, used to name the next one
+        LruTable* resident_; // owned, one entry per value in memory (bytes_ is its mem_size)
+        LruTable* spilled_; // owned, one SpillEntry per value that is in a file
+        KeyIndex index_; // the stored keys of the spilled values, in order
+        size_t spills_; // number of values written out
+        size_t loads_; // number of values loaded back
+        Lock lock_; // guards every field and is held around every use of the shards
+
+        // keeps the values of the given shards within the given budget, spilling to the given
+        // directory (created if it does not exist)
+        SpillStore(KVShard** shards, size_t budget, const char* dir, int idx) : Object() {
+            shards_ = shards;
+            budget_ = budget;
+            dir_ = duplicate(dir);
+            check(mkdir(dir_, 0755) == 0 || errno == EEXIST, "Could not create spill directory");
+            idx_ = idx;
+            files_ = 0;
+            resident_ = new LruTable();
+            spilled_ = new LruTable();
+            spills_ = 0;
+            loads_ = 0;
+        }
+
+        // removes the spill files that are left
+        ~SpillStore() {
+            delete_all();
+            delete resident_;
+            delete spilled_;
+            delete[] dir_;
+        }
+
+        // puts the given key and value into its shard, then spills values until the budget is met
+        // the futures waiting for the key are completed once the lock is released
+        void put(Key* k, DataFrame* v) {
+            lock_.lock();
+            SpillEntry* old = static_cast<SpillEntry*>(spilled_->take(k));
+            if (old != nullptr) {
+                unlink(old->path_);
+                index_.remove(old->stored_);
+                delete old->stored_; // the new key replaces it
+                delete old;
+            }
+            Future* waiting = nullptr;
+            shard_(k)->put(k, v, &waiting);
+            replace_(k, v);
+            evict_();
+            lock_.unlock();
+            complete_chain(waiting, v);
+        }
+
+        // applies the given operation to the value of the given key (loaded back if it was spilled)
+        // then spills values until the budget is met
+        void merge(Key* k, MergeOp op, DataFrame* v) {
+            lock_.lock();
+            load_(k);
+            Future* waiting = nullptr;
+            DataFrame* out = shard_(k)->merge(k, op, v, &waiting);
+            replace_(k, out);
+            evict_();
+            lock_.unlock();
+            complete_chain(waiting, out);
+        }
+
+        // gets the value of the given key, loading it back if it was spilled
+        // if pin is true the value is pinned, and stays in memory until release is called for it
+        // returns nullptr if the key is not in the store
+        DataFrame* get(Key* k, bool pin = false) {
+            lock_.lock();
+            DataFrame* out = resident_get_(k);
+            if (out != nullptr && pin) shard_(k)->get(k, true);
+            evict_();
+            lock_.unlock();
+            return out;
+        }
+
+        // releases a pin of the given value of the given key taken by get or a future, then spills
+        // values until the budget is met
+        void release(Key* k, DataFrame* v) {
+            lock_.lock();
+            shard_(k)->release(v);
+            evict_();
+            lock_.unlock();
+        }
+
+        // completes the given future with the value of the given key as soon as it is put
+        // (right away, after loading it if it was spilled, if it is already in the store)
+        // the value is pinned for the future if it asks for it (see Future::pin_)
+        void when_present(Key* k, Future* f) {
+            lock_.lock();
+            DataFrame* out = resident_get_(k);
+            if (out != nullptr) {
+                if (f->pin_) shard_(k)->get(k, true);
+                evict_();
+            } else shard_(k)->when_present(k, f); // not there, so f is not completed here
+            lock_.unlock();
+            if (out != nullptr) f->complete(out);
+        }
+
+        // waits until the given key is in the store, then returns its value
+        DataFrame* wait_and_get(Key* k) {
+            DataFrame* out = get(k);
+            if (out != nullptr) return out;
+            Future f;
+            when_present(k, &f);
+            return f.get();
+        }
+
+        // removes the given key and deletes its value, whether it is in memory or in a file
+        // a pinned value is deleted by its last release instead (see KVShard::drop)
+        // returns false if the key is not in the store
+        bool remove(Key* k) {
+            lock_.lock();
+            bool out = true;
+            SpillEntry* e = static_cast<SpillEntry*>(spilled_->take(k));
+            if (e != nullptr) {
+                unlink(e->path_);
+                index_.remove(e->stored_);
+                delete e->stored_;
+                delete e;
+            } else {
+                Key* stored = nullptr;
+                DataFrame* df = shard_(k)->remove(k, &stored);
+                out = df != nullptr;
+                delete stored;
+                if (df != nullptr) shard_(k)->drop(df);
+                delete resident_->take(k);
+            }
+            lock_.unlock();
+            return out;
+        }
+
+        // adds copies (owned by the caller) of the spilled keys that start with the given prefix
+        // to out
+        void spilled_with_prefix(const char* prefix, std::vector<Key*>& out) {
+            std::vector<Key*> held;
+            lock_.lock();
+            index_.scan(prefix, nullptr, SIZE_MAX, held);
+            for (Key* k : held) out.push_back(new Key(k->str_, k->idx_));
+            lock_.unlock();
+        }
+
+        // adds copies (owned by the caller) of at most max of the keys of the store, in memory or
+        // in a file, that start with the given prefix and come after the given key string (from
+        // the first if after is nullptr) to out, in order
+        // no value is loaded, and no value moves in or out of the shards during the scan
+        void scan(const char* prefix, const char* after, size_t max, std::vector<Key*>& out) {
+            std::vector<Key*> held;
+            std::vector<Key*> keys;
+            lock_.lock();
+            scan_shards(shards_, prefix, after, max, keys);
+            index_.scan(prefix, after, max, held);
+            for (Key* k : held) keys.push_back(new Key(k->str_, k->idx_));
+            lock_.unlock();
+            sort_keys(keys, max);
+            out.insert(out.end(), keys.begin(), keys.end());
+        }
+
+        // deletes the spilled values and their files (the values in memory are left to the shards)
+        void delete_all() {
+            lock_.lock();
+            while (spilled_->head_ != nullptr) {
+                SpillEntry* e = static_cast<SpillEntry*>(spilled_->take(spilled_->head_->key_));
+                unlink(e->path_);
+                delete e->stored_;
+                delete e;
+            }
+            index_.clear();
+            delete resident_;
+            resident_ = new LruTable();
+            lock_.unlock();
+        }
+
+        // returns the number of values that are in files
+        size_t spilled() {
+            lock_.lock();
+            size_t out = spilled_->size_;
+            lock_.unlock();
+            return out;
+        }
+
+        // returns the shard that holds the given key
+        KVShard* shard_(Key* k) { return shards_[shard_index(k)]; }
+
+        // returns the value of the given key and makes it the most recently used one, loading it
+        // back if it was spilled (nullptr if the key is not in the store)
+        DataFrame* resident_get_(Key* k) {
+            DataFrame* out = shard_(k)->get(k);
+            if (out == nullptr) return load_(k);
+            LruEntry* e = resident_->get(k);
+            // values put before spilling was turned on are counted once they are used
+            if (e != nullptr) resident_->touch(e);
+            else resident_->add(new LruEntry(k, out->mem_size()));
+            return out;
+        }
+
+        // counts the given value as the one of the given key, at its current size
+        void replace_(Key* k, DataFrame* v) {
+            delete resident_->take(k);
+            resident_->add(new LruEntry(k, v->mem_size()));
+        }
+
+        // loads the spilled value of the given key back into its shard and returns it
+        // returns nullptr if the value is not spilled
+        DataFrame* load_(Key* k) {
+            SpillEntry* e = static_cast<SpillEntry*>(spilled_->take(k));
+            if (e == nullptr) return nullptr;
+            DataFrame* out = load_binary(e->path_);
+            unlink(e->path_); // the mapping stays valid without the file
+            index_.remove(e->stored_);
+            shard_(k)->put(e->stored_, out);
+            resident_->add(new LruEntry(k, out->mem_size()));
+            ++loads_;
+            delete e;
+            return out;
+        }
+
+        // writes out the least recently used values until the values in memory fit in the budget
+        // the most recently used value and the pinned ones always stay in memory
+        void evict_() {
+            LruEntry* cur = resident_->tail_;
+            while (resident_->used_ > budget_) {
+                while (cur != nullptr && shard_(cur->key_)->pinned(cur->key_)) cur = cur->prev_;
+                if (cur == nullptr || cur == resident_->head_) break;
+                LruEntry* victim = cur;
+                cur = cur->prev_; // taking the victim unlinks it
+                resident_->take(victim->key_);
+                Key* stored = nullptr;
+                DataFrame* df = shard_(victim->key_)->remove(victim->key_, &stored);
+                check(df != nullptr, "SpillStore: Value is not in its shard");
+
+                StrBuff sb;
+                sb.c(dir_);
+                sb.c("/n");
+                sb.c((size_t)idx_);
+                sb.c('-');
+                sb.c(files_++);
+                sb.c(".bin");
+                char* path = sb.get();
+                save_binary(df, path);
+                delete df;
+                spilled_->add(new SpillEntry(stored, path));
+                index_.add(stored);
+                ++spills_;
+                delete victim;
+            }
+        }
+};
@@ -0,0 +1,71 @@
+// Authors: Zoe Corning (corning.z@husky.neu.edu), Rucha Khanolkar (khanolkar.r@husky.neu.edu)
+// microbenchmark for KDMap: the time per put/get/remove should stay flat as the map grows, and
+// should not pay for the ordered index until the map is scanned
+#include <time.h>
+#include "../../../util/helper.h"
+#include "../key.h"
+#include "../kd_map.h"
+#include "../../dataframe/dataframe.h"
+
+// returns the nanoseconds per operation of the time since start
+double ns_per_op(clock_t start, size_t ops) {
+    return (double)(clock() - start) / CLOCKS_PER_SEC * 1e9 / ops;
+}
+
+// fills a map with n keys, then times gets of present and missing keys and removes
+void bench(size_t n, DataFrame* val) {
+    Key** keys = new Key*[n];
+    for (size_t i = 0; i < n; ++i) keys[i] = Key::make_key("key-", i, 0);
+    Key** missing = new Key*[n];
+    for (size_t i = 0; i < n; ++i) missing[i] = Key::make_key("miss-", i, 0);
+    KDMap* map = new KDMap();
+
+    clock_t start = clock();
+    for (size_t i = 0; i < n; ++i) map->put(keys[i], val);
+    double put = ns_per_op(start, n);
+
+    start = clock();
+    for (size_t i = 0; i < n; ++i) check(map->get(keys[i]) == val, "Missing key");
+    double get = ns_per_op(start, n);
+
+    start = clock();
+    for (size_t i = 0; i < n; ++i) check(!map->contains_key(missing[i]), "Extra key");
+    double miss = ns_per_op(start, n);
+
+    // remove half the keys and put them back, which reuses the tombstones
+    start = clock();
+    for (size_t i = 0; i < n; i += 2) map->remove(keys[i]);
+    for (size_t i = 0; i < n; i += 2) map->put(keys[i], val);
+    double churn = ns_per_op(start, n);
+    check(map->size() == n, "Wrong size");
+
+    // the first scan builds the ordered index, which puts and removes keep up to date after it
+    std::vector<Key*> found;
+    start = clock();
+    map->scan("key-1", nullptr, 10, found);
+    double index = (double)(clock() - start) / CLOCKS_PER_SEC * 1e3;
+    start = clock();
+    for (size_t i = 0; i < n; i += 2) map->remove(keys[i]);
+    for (size_t i = 0; i < n; i += 2) map->put(keys[i], val);
+    double indexed = ns_per_op(start, n);
+
+    printf("%9zu keys: put %7.1f ns  get %7.1f ns  miss %7.1f ns  remove+put %7.1f ns  "
+            "first scan %7.1f ms  indexed remove+put %7.1f ns\n",
+            n, put, get, miss, churn, index, indexed);
+
+    delete map;
+    for (size_t i = 0; i < n; ++i) {
+        delete keys[i];
+        delete missing[i];
+    }
+    delete[] keys;
+    delete[] missing;
+}
+
+int main() {
+    Schema s;
+    DataFrame* val = new DataFrame(s);
+    for (size_t n = 1000; n <= 4000000; n *= 4) bench(n, val);
+    delete val;
+    return 0;
+}
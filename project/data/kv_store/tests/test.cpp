@@ -1,8 +1,13 @@
 // Authors: Zoe Corning (corning.z@husky.neu.edu), Rucha Khanolkar (khanolkar.r@husky.neu.edu)
+#include <atomic>
 #include "../../../util/helper.h"
 #include "../key.h"
 #include "../kv_store.h"
 #include "../kd_map.h"
+#include "../cache.h"
+#include "../spill.h"
+#include "../remote.h"
+#include "../ring.h"
 
 // tests serialization and deserialization on Key
 void testKeySer() {
@@ -24,7 +29,703 @@ void testKeySer() {
     puts("Test Key Serialization Passed");
 }
 
+// tests puts, gets and removes on KDMap, including reusing removed slots and growing
+void testKDMap() {
+    const char* msg = "Test KDMap Failed";
+    Schema s;
+    DataFrame* a = new DataFrame(s);
+    DataFrame* b = new DataFrame(s);
+    KDMap* map = new KDMap();
+    const size_t n = 1000;
+    Key** keys = new Key*[n];
+    for (size_t i = 0; i < n; ++i) {
+        keys[i] = Key::make_key("key-", i, i % 3);
+        check(map->put(keys[i], a) == nullptr, msg);
+    }
+    check(map->size() == n && map->cap_ >= 2 * n, msg);
+
+    Key* copy = Key::make_key("key-", 7, 7 % 3);
+    check(map->get(copy) == a && map->put(copy, b) == a && map->get(keys[7]) == b, msg);
+    check(map->size() == n, msg);
+    Key* other = Key::make_key("key-", 7, 2);
+    check(!map->contains_key(other) && map->get(other) == nullptr, msg);
+
+    // removed keys leave tombstones that later puts reuse
+    size_t cap = map->cap_;
+    for (size_t r = 0; r < 10; ++r) {
+        for (size_t i = 0; i < n; i += 2) check(map->remove(keys[i]) != nullptr, msg);
+        check(map->size() == n / 2 && !map->contains_key(keys[0]), msg);
+        check(map->remove(keys[0]) == nullptr, msg);
+        for (size_t i = 0; i < n; i += 2) check(map->put(keys[i], a) == nullptr, msg);
+    }
+    check(map->size() == n && map->cap_ == cap, msg);
+    for (size_t i = 0; i < n; ++i) check(map->get(keys[i]) == (i == 7 ? b : a), msg);
+
+    delete map;
+    for (size_t i = 0; i < n; ++i) delete keys[i];
+    delete[] keys;
+    delete copy;
+    delete other;
+    delete a;
+    delete b;
+
+    puts("Test KDMap Passed");
+}
+
+// tests that removing most keys of a KDMap shrinks it, removing from a SpillStore deletes
+// values in memory and in files, and a value removed while pinned lives until its release
+void testRemove() {
+    const char* msg = "Test Remove Failed";
+    Schema s;
+    DataFrame* a = new DataFrame(s);
+    KDMap* map = new KDMap();
+    const size_t n = 1000;
+    Key** keys = new Key*[n];
+    for (size_t i = 0; i < n; ++i) {
+        keys[i] = Key::make_key(i % 100 == 0 ? "keep-" : "drop-", i, 0);
+        map->put(keys[i], a);
+    }
+    size_t cap = map->cap_;
+    std::vector<Key*> found;
+    map->keys_with_prefix("keep-", found);
+    check(found.size() == n / 100, msg);
+    found.clear();
+    map->keys_with_prefix("drop-", found);
+    for (Key* k : found) check(map->remove(k) == a, msg);
+    check(map->size() == n / 100 && map->cap_ < cap && map->tombs_ * 4 < map->cap_, msg);
+    for (size_t i = 0; i < n; ++i) check((map->get(keys[i]) == a) == (i % 100 == 0), msg);
+
+    const char* dir = "remove_test";
+    KVShard* shards[KV_SHARDS];
+    for (size_t i = 0; i < KV_SHARDS; ++i) shards[i] = new KVShard();
+    int vals[4] = {1, 2, 3, 4};
+    DataFrame* sample = DataFrame::from_array(4, vals);
+    SpillStore* spill = new SpillStore(shards, sample->mem_size(), dir, 0);
+    delete sample;
+    Key* first = new Key("first", 0);
+    Key* second = new Key("second", 0);
+    spill->put(first, DataFrame::from_array(4, vals));
+    spill->put(second, DataFrame::from_array(4, vals));
+    check(spill->spilled() == 1, msg);
+    found.clear();
+    spill->spilled_with_prefix("fir", found);
+    check(found.size() == 1 && found[0]->equals(first), msg);
+    delete found[0];
+    // the store deletes its keys (first and second) with the values
+    Key* copy = new Key("first", 0);
+    check(spill->remove(copy) && spill->spilled() == 0 && spill->get(copy) == nullptr, msg);
+    Key* copy2 = new Key("second", 0);
+    check(spill->remove(copy2) && spill->get(copy2) == nullptr, msg);
+    check(! spill->remove(copy) && spill->resident_->size_ == 0, msg);
+
+    // a pinned value that is removed is still readable, and is deleted by its release
+    Key* held = new Key("held", 0);
+    KVShard* holder = shards[shard_index(held)];
+    spill->put(held, DataFrame::from_array(4, vals));
+    DataFrame* v = spill->get(held, true);
+    Key* held_copy = new Key("held", 0);
+    check(spill->remove(held_copy) && spill->get(held_copy) == nullptr, msg);
+    check(holder->retired_.count(v) == 1 && v->get_int(0, 3) == 4, msg);
+    spill->release(held_copy, v);
+    check(holder->retired_.empty() && holder->pins_.empty(), msg);
+
+    // the same without spilling
+    Key* local = new Key("local", 0);
+    holder = shards[shard_index(local)];
+    holder->put(local, DataFrame::from_array(4, vals));
+    v = holder->get(local, true);
+    Key* stored = nullptr;
+    check(holder->remove(local, &stored) == v, msg);
+    holder->drop(v);
+    check(holder->retired_.count(v) == 1 && v->get_int(0, 0) == 1, msg);
+    holder->release(v);
+    check(holder->retired_.empty() && holder->pins_.empty(), msg);
+    delete stored;
+    delete held_copy;
+
+    delete spill;
+    for (size_t i = 0; i < KV_SHARDS; ++i) delete shards[i];
+    check(rmdir(dir) == 0, msg); // fails if a spill file is left
+    delete copy;
+    delete copy2;
+    delete map;
+    for (size_t i = 0; i < n; ++i) delete keys[i];
+    delete[] keys;
+    delete a;
+
+    puts("Test Remove Passed");
+}
+
+// tests that prefix scans list keys in order, in batches that continue after a key string, from
+// the index of a KDMap, of several shards and of a spill store
+void testScan() {
+    const char* msg = "Test Scan Failed";
+    Schema s;
+    DataFrame* a = new DataFrame(s);
+    KDMap* map = new KDMap();
+    const size_t n = 300;
+    Key** keys = new Key*[n];
+    for (size_t i = 0; i < n; ++i) {
+        keys[i] = Key::make_key(i % 3 == 0 ? "ct_" : "cu_", i, 0);
+        map->put(keys[i], a);
+    }
+    // the index is only built by the first scan
+    check(! map->indexed_ && map->index_.size() == 0, msg);
+
+    // every ct_ key once, in order, in batches of 7
+    std::vector<Key*> found;
+    const char* after = nullptr;
+    size_t total = 0;
+    while (true) {
+        found.clear();
+        map->scan("ct_", after, 7, found);
+        for (size_t i = 0; i < found.size(); ++i) {
+            check(starts_with(found[i]->str_, "ct_"), msg);
+            if (i > 0) check(strcmp(found[i - 1]->str_, found[i]->str_) < 0, msg);
+        }
+        if (after != nullptr && ! found.empty()) check(strcmp(after, found[0]->str_) < 0, msg);
+        total += found.size();
+        if (found.size() < 7) break;
+        after = found.back()->str_;
+    }
+    check(total == n / 3 && map->indexed_ && map->index_.size() == n, msg);
+    map->put(keys[0], a); // puts of a key that is already there do not add it to the index again
+    check(map->index_.size() == n, msg);
+    found.clear();
+    map->scan("ct_1", nullptr, SIZE_MAX, found);
+    // ct_102 ... ct_198, then ct_12, ct_15 and ct_18
+    check(found.size() == 36 && streq(found[0]->str_, "ct_102"), msg);
+    found.clear();
+    map->scan("", "cu_", SIZE_MAX, found); // an empty prefix lists everything after the string
+    check(found.size() == n - n / 3, msg);
+
+    // removed keys leave the index
+    for (size_t i = 0; i < n; ++i) if (i % 2 == 0) map->remove(keys[i]);
+    found.clear();
+    map->scan("ct_", nullptr, SIZE_MAX, found);
+    check(found.size() == n / 6, msg);
+    for (Key* k : found) check(map->contains_key(k), msg);
+    for (size_t i = 1; i < n; i += 2) map->remove(keys[i]);
+    check(map->index_.size() == 0, msg);
+    for (size_t i = 0; i < n; ++i) delete keys[i];
+    delete[] keys;
+    delete map;
+
+    // sorting merges the batches of several indexes, dropping duplicates
+    std::vector<Key*> merged;
+    merged.push_back(new Key("b", 0));
+    merged.push_back(new Key("a", 0));
+    merged.push_back(new Key("b", 0));
+    merged.push_back(new Key("c", 0));
+    sort_keys(merged, 2);
+    check(merged.size() == 2 && streq(merged[0]->str_, "a") && streq(merged[1]->str_, "b"), msg);
+    for (Key* k : merged) delete k;
+
+    // the keys of every shard and the spilled keys are listed in one order
+    const char* dir = "scan_test";
+    KVShard* shards[KV_SHARDS];
+    for (size_t i = 0; i < KV_SHARDS; ++i) shards[i] = new KVShard();
+    int vals[4] = {1, 2, 3, 4};
+    DataFrame* sample = DataFrame::from_array(4, vals);
+    SpillStore* spill = new SpillStore(shards, sample->mem_size() * 4, dir, 0);
+    delete sample;
+    for (size_t i = 0; i < 40; ++i) {
+        spill->put(Key::make_key(i % 2 == 0 ? "ct_" : "cu_", i, 0), DataFrame::from_array(4, vals));
+    }
+    check(spill->spilled() == 36, msg);
+    std::vector<Key*> listed;
+    spill->scan("ct_", nullptr, 8, listed);
+    spill->scan("ct_", listed.back()->str_, 100, listed);
+    check(listed.size() == 20 && spill->spilled() == 36, msg); // nothing is loaded back
+    for (size_t i = 1; i < listed.size(); ++i) {
+        check(strcmp(listed[i - 1]->str_, listed[i]->str_) < 0, msg);
+    }
+    for (Key* k : listed) {
+        check(spill->get(k) != nullptr, msg);
+        delete k;
+    }
+    listed.clear();
+    scan_shards(shards, "ct_", nullptr, 100, listed); // the last ones loaded are in the shards
+    check(! listed.empty() && listed.size() < 20, msg);
+    for (Key* k : listed) delete k;
+
+    delete spill;
+    for (size_t i = 0; i < KV_SHARDS; ++i) {
+        shards[i]->kdm_->delete_all();
+        delete shards[i];
+    }
+    check(rmdir(dir) == 0, msg); // fails if a spill file is left
+    delete a;
+
+    puts("Test Scan Passed");
+}
+
+// tests that keys hash well: anagrams and different nodes do not collide, equal keys do
+void testKeyHash() {
+    const char* msg = "Test Key Hash Failed";
+    Key* a = new Key("nu-12", 0);
+    Key* b = new Key("nu-21", 0);
+    Key* c = new Key("nu-12", 1);
+    Key* d = Key::make_key("nu-", 12, 0);
+    check(a->hash() != b->hash() && a->hash() != c->hash(), msg);
+    check(!a->equals(b) && !a->equals(c), msg);
+    check(a->hash() == d->hash() && a->equals(d) && d->len_ == 5, msg);
+
+    // no two of many similar keys share a hash
+    const size_t n = 10000;
+    size_t* hashes = new size_t[n];
+    for (size_t i = 0; i < n; ++i) {
+        Key* k = Key::make_key("w-", i, 0);
+        hashes[i] = k->hash();
+        delete k;
+    }
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = i + 1; j < n; ++j) check(hashes[i] != hashes[j], msg);
+    }
+    delete[] hashes;
+
+    delete a;
+    delete b;
+    delete c;
+    delete d;
+
+    puts("Test Key Hash Passed");
+}
+
+// tests that writers holding an RWLock exclude readers and other writers
+void testRWLock() {
+    const char* msg = "Test RWLock Failed";
+    RWLock* lock = new RWLock();
+    std::atomic<int> readers(0);
+    int writes = 0;
+    std::thread threads[8];
+    for (int t = 0; t < 8; ++t) {
+        threads[t] = std::thread([&, t]{
+            for (int i = 0; i < 1000; ++i) {
+                if (t % 2 == 0) {
+                    lock->lock_write();
+                    check(readers == 0, msg);
+                    ++writes;
+                    lock->unlock_write();
+                } else {
+                    lock->lock_read();
+                    ++readers;
+                    std::this_thread::yield();
+                    --readers;
+                    lock->unlock_read();
+                }
+            }
+        });
+    }
+    for (int t = 0; t < 8; ++t) threads[t].join();
+    check(writes == 4000, msg);
+    delete lock;
+
+    puts("Test RWLock Passed");
+}
+
+// counts how many times it is completed
+class CountingFuture : public Future {
+    public:
+        size_t completed_ = 0;
+        void complete(DataFrame* v) { ++completed_; Future::complete(v); }
+};
+
+// tests that a put completes only the futures waiting for its key
+void testFutureTable() {
+    const char* msg = "Test Future Table Failed";
+    KVShard* shard = new KVShard();
+    Schema s;
+    DataFrame* a = new DataFrame(s);
+    DataFrame* b = new DataFrame(s);
+    Key* ka = new Key("a", 0);
+    Key* kb = new Key("b", 0);
+    CountingFuture fa1, fa2, fb;
+    shard->when_present(ka, &fa1);
+    shard->when_present(ka, &fa2);
+    shard->when_present(kb, &fb);
+    check(shard->waiting_->size_ == 3 && !fa1.ready(), msg);
+
+    shard->put(ka, a);
+    check(fa1.get() == a && fa2.get() == a && fa1.completed_ == 1 && fa2.completed_ == 1, msg);
+    check(!fb.ready() && fb.completed_ == 0 && shard->waiting_->size_ == 1, msg);
+
+    // a key that is already present completes the future right away
+    CountingFuture fa3;
+    shard->when_present(ka, &fa3);
+    check(fa3.ready() && fa3.get() == a && shard->waiting_->size_ == 1, msg);
+
+    shard->put(kb, b);
+    check(fb.get() == b && fb.completed_ == 1 && shard->waiting_->size_ == 0, msg);
+
+    // every request gets its own id, even requests for the same key
+    RequestTable requests;
+    CountingFuture f1, f2, f3;
+    size_t id1 = requests.add(&f1);
+    size_t id2 = requests.add(&f2);
+    size_t id3 = requests.add(&f3);
+    check(id1 != id2 && id2 != id3 && id1 != id3 && requests.size_ == 3, msg);
+    check(requests.take(id2) == &f2 && requests.take(id2) == nullptr, msg);
+    check(requests.take(id3) == &f3 && requests.take(id1) == &f1 && requests.size_ == 0, msg);
+
+    shard->kdm_->delete_all();
+    delete shard;
+
+    puts("Test Future Table Passed");
+}
+
+// tests that threads waiting on a shard wake up with their own key's value
+void testShard() {
+    const char* msg = "Test Shard Failed";
+    KVShard* shard = new KVShard();
+    Schema s;
+    const size_t n = 8;
+    Key* keys[n];
+    DataFrame* vals[n];
+    DataFrame* got[n];
+    std::thread threads[n];
+    for (size_t i = 0; i < n; ++i) {
+        keys[i] = Key::make_key("wait-", i, 0);
+        vals[i] = new DataFrame(s);
+        threads[i] = std::thread([&, i]{ got[i] = shard->wait_and_get(keys[i]); });
+    }
+    for (size_t i = 0; i < n; ++i) shard->put(keys[i], vals[i]);
+    for (size_t i = 0; i < n; ++i) {
+        threads[i].join();
+        check(got[i] == vals[i], msg);
+    }
+    check(shard->size() == n && shard->get(keys[3]) == vals[3], msg);
+    check(shard->waiting_->size_ == 0, msg);
+
+    shard->kdm_->delete_all();
+    delete shard;
+
+    puts("Test Shard Passed");
+}
+
+// tests that the cache hands out copies, drops the least recently used values first and
+// stays within its budget
+void testCache() {
+    const char* msg = "Test Cache Failed";
+    Schema s("IS");
+    s.add_row();
+    DataFrame* df = new DataFrame(s);
+    df->set(0, 0, 5);
+    String* str = new String("hello");
+    df->set(1, 0, str);
+    size_t bytes = df->mem_size();
+
+    RemoteCache* cache = new RemoteCache(bytes * 2);
+    Key* a = new Key("a", 1);
+    Key* b = new Key("b", 1);
+    Key* c = new Key("c", 1);
+    check(cache->get(a) == nullptr && cache->misses_ == 1, msg);
+    cache->put(a, df);
+    cache->put(b, df);
+    DataFrame* got = cache->get(a); // a is now used more recently than b
+    check(got != nullptr && got != df && got->get_int(0, 0) == 5, msg);
+    check(got->get_string(1, 0) != str && got->get_string(1, 0)->equals(str), msg);
+    delete got;
+
+    cache->put(c, df); // over budget, drops b
+    check(cache->size() == 2 && cache->used() <= cache->budget_, msg);
+    got = cache->get(b);
+    check(got == nullptr, msg);
+    got = cache->get(c);
+    check(got != nullptr, msg);
+    delete got;
+
+    cache->invalidate(a);
+    got = cache->get(a);
+    check(got == nullptr && cache->size() == 1 && cache->hits_ == 2, msg);
+
+    // a value bigger than the whole budget is not cached
+    RemoteCache* tiny = new RemoteCache(bytes - 1);
+    tiny->put(a, df);
+    check(tiny->size() == 0 && tiny->used() == 0, msg);
+
+    delete tiny;
+    delete cache;
+    delete a;
+    delete b;
+    delete c;
+    delete df;
+
+    puts("Test Cache Passed");
+}
+
+// tests that values over the memory budget are written out and loaded back when they are used
+void testSpill() {
+    const char* msg = "Test Spill Failed";
+    const char* dir = "spill_test";
+    KVShard* shards[KV_SHARDS];
+    for (size_t i = 0; i < KV_SHARDS; ++i) shards[i] = new KVShard();
+    const size_t n = 6;
+    Key* keys[n];
+    int vals[4] = {1, 2, 3, 4};
+    DataFrame* sample = DataFrame::from_array(4, vals);
+    size_t bytes = sample->mem_size();
+    delete sample;
+    SpillStore* spill = new SpillStore(shards, bytes * 2, dir, 0);
+
+    for (size_t i = 0; i < n; ++i) {
+        keys[i] = Key::make_key("spill-", i, 0);
+        vals[0] = i;
+        spill->put(keys[i], DataFrame::from_array(4, vals));
+    }
+    // only the two most recently used values fit
+    check(spill->spills_ == n - 2 && spill->spilled() == n - 2, msg);
+    check(spill->resident_->used_ <= spill->budget_, msg);
+    check(shards[shard_index(keys[0])]->get(keys[0]) == nullptr, msg);
+
+    // a spilled value is loaded back with the same data, and another one is written out
+    DataFrame* df = spill->get(keys[0]);
+    check(df != nullptr && df->get_int(0, 0) == 0 && df->get_int(0, 3) == 4, msg);
+    check(spill->loads_ == 1 && spill->spills_ == n - 1 && spill->spilled() == n - 2, msg);
+    df = spill->wait_and_get(keys[1]);
+    check(df != nullptr && df->get_int(0, 0) == 1 && spill->loads_ == 2, msg);
+
+    // putting a spilled key again replaces the spilled value (and the store's old key)
+    vals[0] = 100;
+    Key* again = Key::make_key("spill-", 2, 0);
+    spill->put(again, DataFrame::from_array(4, vals));
+    df = spill->get(again);
+    check(df->get_int(0, 0) == 100 && spill->loads_ == 2, msg);
+
+    // waiting for a key that is not there yet still works
+    CountingFuture f;
+    Key* later = new Key("later", 0);
+    spill->when_present(later, &f);
+    check(!f.ready(), msg);
+    spill->put(later, DataFrame::from_array(4, vals));
+    check(f.ready() && f.get()->get_int(0, 0) == 100, msg);
+
+    // a pinned value is not written out until it is released
+    DataFrame* pinned = spill->get(keys[3], true);
+    spill->get(keys[4]);
+    spill->get(keys[5]);
+    check(shards[shard_index(keys[3])]->get(keys[3]) == pinned, msg);
+    spill->release(keys[3], pinned);
+    spill->get(keys[0]);
+    check(shards[shard_index(keys[3])]->get(keys[3]) == nullptr, msg);
+
+    // a future that asks for it is completed with a pinned value
+    CountingFuture g;
+    g.pin_ = true;
+    Key* held = new Key("held", 0);
+    spill->when_present(held, &g);
+    spill->put(held, DataFrame::from_array(4, vals));
+    KVShard* holder = shards[shard_index(held)];
+    check(g.ready() && holder->pins_.count(g.get()) == 1 && holder->pins_[g.get()] == 1, msg);
+    spill->release(held, g.get());
+    check(holder->pins_.empty(), msg);
+
+    spill->delete_all();
+    check(spill->spilled() == 0, msg);
+    for (size_t i = 0; i < KV_SHARDS; ++i) {
+        shards[i]->kdm_->delete_all();
+        delete shards[i];
+    }
+    delete spill;
+    check(rmdir(dir) == 0, msg); // fails if a spill file is left
+
+    puts("Test Spill Passed");
+}
+
+// tests the merge operations, and that concurrent increments of the same key are not lost
+void testMerge() {
+    const char* msg = "Test Merge Failed";
+    int a[3] = {1, 2, 3};
+    int b[3] = {10, 20, 30};
+    DataFrame* da = DataFrame::from_array(3, a);
+    DataFrame* db = DataFrame::from_array(3, b);
+    merge_into(MergeOp::Add, da, db);
+    check(da->get_int(0, 0) == 11 && da->get_int(0, 2) == 33 && db->get_int(0, 2) == 30, msg);
+    merge_into(MergeOp::Append, da, db);
+    check(da->nrows() == 6 && da->get_int(0, 5) == 30, msg);
+    DataFrame* dmin = DataFrame::from_array(3, a);
+    merge_into(MergeOp::Min, db, dmin);
+    check(db->get_int(0, 0) == 1 && db->get_int(0, 2) == 3, msg);
+    int c[3] = {0, 5, 9};
+    DataFrame* dc = DataFrame::from_array(3, c);
+    merge_into(MergeOp::Max, db, dc);
+    check(db->get_int(0, 0) == 1 && db->get_int(0, 1) == 5 && db->get_int(0, 2) == 9, msg);
+
+    // union only adds the elements that are not in the set yet, each once
+    int u[4] = {9, 7, 7, 0};
+    DataFrame* du = DataFrame::from_array(4, u);
+    merge_into(MergeOp::Union, dc, du);
+    check(dc->nrows() == 4 && dc->get_int(0, 3) == 7, msg);
+
+    bool x[3] = {true, false, false};
+    bool y[3] = {false, false, true};
+    DataFrame* dx = DataFrame::from_array(3, x);
+    DataFrame* dy = DataFrame::from_array(3, y);
+    merge_into(MergeOp::Or, dx, dy);
+    check(dx->get_bool(0, 0) && !dx->get_bool(0, 1) && dx->get_bool(0, 2), msg);
+
+    String* str = new String("word");
+    DataFrame* ds = DataFrame::from_scalar(str);
+    DataFrame* ds2 = DataFrame::from_scalar(str->clone());
+    merge_into(MergeOp::Append, ds, ds2);
+    check(ds->nrows() == 2 && ds->get_string(0, 1) != str && ds->get_string(0, 1)->equals(str), msg);
+
+    // a missing key gets a copy of the operand, and wakes up the threads waiting for it
+    KVShard* shard = new KVShard();
+    Key* k = new Key("count", 0);
+    CountingFuture f;
+    shard->when_present(k, &f);
+    const size_t nthreads = 4;
+    const int per_thread = 1000;
+    std::thread threads[nthreads];
+    DataFrame* one = DataFrame::from_scalar(1);
+    for (size_t i = 0; i < nthreads; ++i) {
+        threads[i] = std::thread([&]{
+            for (int j = 0; j < per_thread; ++j) shard->merge(k, MergeOp::Add, one);
+        });
+    }
+    for (size_t i = 0; i < nthreads; ++i) threads[i].join();
+    DataFrame* count = shard->get(k);
+    check(count != nullptr && count != one && count->get_int(0, 0) == nthreads * per_thread, msg);
+    // counts are added in place
+    check(f.completed_ == 1 && f.get() == count, msg);
+
+    // an append to a value nobody pinned is in place too, but a pinned value is replaced by a
+    // merged copy, and deleted by its last release
+    Key* list = new Key("list", 0);
+    shard->merge(list, MergeOp::Append, one);
+    DataFrame* first = shard->get(list);
+    check(shard->merge(list, MergeOp::Append, one) == first && first->nrows() == 2, msg);
+    check(shard->get(list, true) == first && shard->pinned(list), msg);
+    DataFrame* second = shard->merge(list, MergeOp::Append, one);
+    check(second != first && first->nrows() == 2 && second->nrows() == 3, msg);
+    check(shard->retired_.count(first) == 1 && ! shard->pinned(list), msg);
+    shard->release(first);
+    check(shard->retired_.empty() && shard->pins_.empty(), msg);
+    delete list;
+
+    shard->kdm_->delete_all();
+    delete shard;
+    delete k;
+    delete one;
+    delete da;
+    delete db;
+    delete dmin;
+    delete dc;
+    delete du;
+    delete dx;
+    delete dy;
+    delete ds; // owns str
+    delete ds2;
+
+    puts("Test Merge Passed");
+}
+
+// adds up the ints of one column, the column is its state and the sum its result
+class SumRower : public RemoteRower {
+    public:
+        size_t col_;
+        int sum_ = 0;
+
+        SumRower(size_t col) : RemoteRower() { col_ = col; }
+
+        static RemoteRower* make(DataFrame* state) { return new SumRower(state->get_int(0, 0)); }
+
+        bool accept(Row& r) {
+            sum_ += r.get_int(col_);
+            return true;
+        }
+
+        const char* name() { return "sum"; }
+
+        DataFrame* state() { return DataFrame::from_scalar((int)col_); }
+
+        DataFrame* result() { return DataFrame::from_scalar(sum_); }
+};
+
+// tests registering rowers and running one made from the state of another
+void testRegistry() {
+    const char* msg = "Test Registry Failed";
+    RowerRegistry* reg = new RowerRegistry();
+    check(! reg->has("sum"), msg);
+    reg->add("sum", SumRower::make);
+    check(reg->has("sum") && ! reg->has("su"), msg);
+
+    Schema* s = new Schema("II");
+    DataFrame* df = new DataFrame(*s);
+    delete s;
+    for (int i = 0; i < 10; ++i) {
+        df->get_col_(0)->push_back(i);
+        df->get_col_(1)->push_back(2 * i);
+        df->get_schema().add_row();
+    }
+
+    SumRower sr(1);
+    DataFrame* state = sr.state();
+    RemoteRower* copy = reg->make(sr.name(), state);
+    DataFrame* out = run_rower(copy, df);
+    check(out->nrows() == 1 && out->get_int(0, 0) == 90 && sr.sum_ == 0, msg);
+    RemoteRower* none = reg->make("sum", state);
+    check(run_rower(none, nullptr) == nullptr, msg);
+
+    delete reg;
+    delete df;
+    delete state;
+    delete copy;
+    delete out;
+    delete none;
+
+    puts("Test Registry Passed");
+}
+
+// tests that a hash ring spreads keys evenly and only moves keys to a node that is added
+void testRing() {
+    const char* msg = "Test Ring Failed";
+    const size_t nkeys = 20000;
+    HashRing* ring = new HashRing(8, RING_VNODES);
+    HashRing* same = new HashRing(8, RING_VNODES);
+    HashRing* grown = new HashRing(9, RING_VNODES);
+    size_t counts[8] = {0};
+    size_t moved = 0;
+    for (size_t i = 0; i < nkeys; ++i) {
+        Key* k = Key::make_key("key-", i, 0);
+        char* str = k->str_;
+        int owner = ring->owner(str);
+        check(owner >= 0 && owner < 8 && same->owner(str) == owner, msg);
+        ++counts[owner];
+        int now = grown->owner(str);
+        if (now != owner) {
+            check(now == 8, msg); // keys only move to the new node
+            ++moved;
+        }
+        delete k;
+    }
+    for (size_t n = 0; n < 8; ++n) {
+        check(counts[n] > nkeys / 8 / 2 && counts[n] < nkeys / 8 * 3 / 2, msg);
+    }
+    // about 1 / 9 of the keys move
+    check(moved > nkeys / 9 / 2 && moved < nkeys / 9 * 2, msg);
+
+    delete ring;
+    delete same;
+    delete grown;
+
+    puts("Test Ring Passed");
+}
+
 int main() {
     testKeySer();
+    testKeyHash();
+    testKDMap();
+    testRemove();
+    testScan();
+    testRWLock();
+    testShard();
+    testFutureTable();
+    testCache();
+    testSpill();
+    testMerge();
+    testRegistry();
+    testRing();
     return 0;
 }
@@ -0,0 +1,19 @@
+// Authors: Zoe Corning (corning.z@husky.neu.edu) & Rucha Khanolkar (khanolkar.r@husky.neu.edu)
+#include "sorer.h"
+#include "../dataframe/binary.h"
+#include "../dataframe/dataframe.h"
+#include "../../util/helper.h"
+
+// converts a SoR file (ex. .sor or .ltgt) into the binary DataFrame format (see binary.h)
+// so later runs can load it with load_binary() instead of parsing the text again
+// Usage: ./sor2bin <sor_file> <binary_file>
+int main(int argc, char** argv) {
+    check(argc == 3, "Usage: ./sor2bin <sor_file> <binary_file>");
+
+    DataFrame* df = interpret_file(argv[1], 0, 0);
+    save_binary(df, argv[2]);
+    printf("Converted %s to %s: %lu rows x %lu cols\n", argv[1], argv[2], df->nrows(), df->ncols());
+    delete df;
+
+    return 0;
+}
@@ -1,6 +1,8 @@
 // Authors: Zoe Corning(corning.z@husky.neu.edu) & Rucha Khanolkar(khanolkar.r@husky.neu.edu)
 
+#include <sys/wait.h>
 #include "../sorer.h"
+#include "../../dataframe/binary.h"
 #include "../../dataframe/column.h"
 #include "../../dataframe/schema.h"
 #include "../../dataframe/dataframe.h"
@@ -91,6 +93,309 @@ void test4() {
     puts("Test 4 Passed");
 }
 
+// keeps rows whose int in the given column is greater than min_
+// counts how many fields it was asked about so short-circuiting can be checked
+class MinIntFilter : public SorFilter {
+    public:
+        size_t col_;
+        int min_;
+        size_t calls_;
+
+        MinIntFilter(size_t col, int min) : SorFilter() {
+            col_ = col;
+            min_ = min;
+            calls_ = 0;
+        }
+
+        bool accept(size_t col, bool b) { ++calls_; return true; }
+        bool accept(size_t col, int i) { ++calls_; return col != col_ || i > min_; }
+        bool accept(size_t col, float f) { ++calls_; return true; }
+        bool accept(size_t col, const char* s) { ++calls_; return true; }
+};
+
+// keeps rows whose string in column 0 does not start with a digit or sign
+class WordFilter : public SorFilter {
+    public:
+        bool accept(size_t col, const char* s) { return strchr("+-.0123456789", s[0]) == nullptr; }
+};
+
+// tests filters pushed down into interpret_file
+void testFilter() {
+    const char* msg = "Test Filter Failed";
+    MinIntFilter* mf = new MinIntFilter(1, 5);
+    DataFrame* df = interpret_file("2.sor", 0, 0, mf);
+
+    check(df->nrows() == 1, msg);
+    check(df->ncols() == 4, msg);
+    check(df->get_int(1, 0) == 12, msg);
+    check(df->get_string(3, 0)->equals("ho ho ho"), msg);
+    // first row is rejected at column 1, so columns 2 and 3 of it are never looked at
+    check(mf->calls_ == 2 + 4, msg);
+    delete df;
+    delete mf;
+
+    WordFilter* wf = new WordFilter();
+    df = interpret_file("1.sor", 0, 0, wf);
+    check(df->nrows() == 5, msg);
+    check(df->get_string(0, 0)->equals("abc"), msg);
+    check(df->get_string(0, 1)->equals("hello"), msg);
+    check(df->get_string(0, 4)->equals("bye"), msg);
+    delete df;
+    delete wf;
+
+    puts("Test Filter Passed");
+}
+
+// tests that consecutive byte ranges read every row exactly once when given a shared schema
+void testRanges() {
+    const char* msg = "Test Ranges Failed";
+    Schema* s = infer_schema("1.sor");
+    check(s->width() == 1 && s->length() == 0 && s->col_type(0) == 'S', msg);
+
+    size_t size = file_size("1.sor");
+    const size_t n = 4;
+    size_t row = 0;
+    DataFrame* all = interpret_file("1.sor", 0, 0);
+    for (size_t i = 0; i < n; ++i) {
+        size_t from = i * (size / n);
+        size_t len = i == n - 1 ? size - from : size / n;
+        DataFrame* df = interpret_file("1.sor", from, len, s, nullptr);
+        check(df->get_schema().col_type(0) == 'S', msg);
+        for (size_t r = 0; r < df->nrows(); ++r, ++row) {
+            check(df->get_string(0, r)->equals(all->get_string(0, row)), msg);
+        }
+        delete df;
+    }
+    check(row == all->nrows(), msg);
+
+    delete all;
+    delete s;
+
+    puts("Test Ranges Passed");
+}
+
+// tests saving a parsed file in the binary format and loading it back through a mapping
+void testBinary() {
+    const char* msg = "Test Binary Failed";
+    DataFrame* df = interpret_file("2.sor", 0, 0);
+    save_binary(df, "2.df");
+    DataFrame* bin = load_binary("2.df");
+
+    check(bin->nrows() == df->nrows() && bin->ncols() == df->ncols(), msg);
+    for (size_t i = 0; i < df->ncols(); ++i) {
+        check(bin->get_schema().col_type(i) == df->get_schema().col_type(i), msg);
+    }
+    for (size_t r = 0; r < df->nrows(); ++r) {
+        check(bin->get_bool(0, r) == df->get_bool(0, r), msg);
+        check(bin->get_int(1, r) == df->get_int(1, r), msg);
+        check(float_eq(bin->get_float(2, r), df->get_float(2, r)), msg);
+        check(bin->get_string(3, r)->equals(df->get_string(3, r)), msg);
+    }
+    // numeric columns point into the mapped file
+    check(bin->get_col_(1)->as_int()->external_, msg);
+    // writes stay in memory, and pushing copies the column out of the mapping
+    bin->set(1, 0, 7);
+    check(bin->get_int(1, 0) == 7, msg);
+    bin->get_col_(1)->push_back(8);
+    check(!bin->get_col_(1)->as_int()->external_ && bin->get_col_(1)->as_int()->get(2) == 8, msg);
+    delete bin;
+
+    // the file itself was not changed
+    bin = load_binary("2.df");
+    check(bin->get_int(1, 0) == df->get_int(1, 0), msg);
+    delete bin;
+
+    delete df;
+    unlink("2.df");
+
+    puts("Test Binary Passed");
+}
+
+// returns true if loading the given binary file fails with an error (in a child process, since
+// a failed check exits)
+bool load_fails(const char* path) {
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid == 0) {
+        freopen("/dev/null", "w", stderr);
+        delete load_binary(path);
+        _exit(0);
+    }
+    int status;
+    waitpid(pid, &status, 0);
+    return ! WIFEXITED(status) || WEXITSTATUS(status) != 0;
+}
+
+// tests that a truncated or corrupt binary file is rejected instead of read out of bounds
+void testBinaryCorrupt() {
+    const char* msg = "Test Binary Corrupt Failed";
+    DataFrame* df = interpret_file("2.sor", 0, 0);
+    save_binary(df, "2c.df");
+    check(! load_fails("2c.df"), msg);
+    struct stat st;
+    check(stat("2c.df", &st) == 0, msg);
+
+    // the arena of the strings is cut off
+    check(truncate("2c.df", st.st_size - 1) == 0, msg);
+    check(load_fails("2c.df"), msg);
+
+    // the offset of the first block points past the end of the file
+    save_binary(df, "2c.df");
+    int fd = open("2c.df", O_RDWR);
+    uint64_t off = st.st_size;
+    check(pwrite(fd, &off, sizeof(off), BIN_HEADER + align8(df->ncols())) == sizeof(off), msg);
+    close(fd);
+    check(load_fails("2c.df"), msg);
+
+    // a huge row count
+    save_binary(df, "2c.df");
+    fd = open("2c.df", O_RDWR);
+    uint64_t rows = UINT64_MAX / 2;
+    check(pwrite(fd, &rows, sizeof(rows), 8 + sizeof(uint64_t)) == sizeof(rows), msg);
+    close(fd);
+    check(load_fails("2c.df"), msg);
+
+    delete df;
+    unlink("2c.df");
+
+    puts("Test Binary Corrupt Passed");
+}
+
+// tests the sidecar index: cached types, row counts, jumping to rows by index and staleness
+void testIndex() {
+    const char* msg = "Test Index Failed";
+    unlink("1.sor.idx");
+    check(load_index("1.sor") == nullptr, msg);
+    // inferring the schema only reads the first lines, and caches the types without the rows
+    Schema* s = infer_schema("1.sor");
+    check(s->width() == 1 && s->col_type(0) == 'S', msg);
+    delete s;
+    SorIndex* idx = load_index("1.sor");
+    check(idx != nullptr && ! idx->has_rows() && idx->nrows_ == 0 && idx->offsets_.empty(), msg);
+    check(idx->types_.size() == 1 && idx->types_[0] == TYPE_STRING, msg);
+    delete idx;
+
+    // a second read of a file takes its types from the sidecar the first one wrote
+    const char* ints = "index_types.sor";
+    FILE* f = fopen(ints, "w");
+    fputs("<1>\n<2>\n", f);
+    fclose(f);
+    unlink("index_types.sor.idx");
+    DataFrame* df = interpret_file(ints, 0, 0);
+    check(df->get_schema().col_type(0) == 'I' && df->nrows() == 2, msg);
+    delete df;
+    idx = load_index(ints);
+    check(idx != nullptr && idx->types_.size() == 1 && idx->types_[0] == TYPE_INT, msg);
+    idx->types_[0] = TYPE_STRING; // only the sidecar says so
+    save_index(idx, ints);
+    delete idx;
+    df = interpret_file(ints, 0, 0);
+    check(df->get_schema().col_type(0) == 'S' && df->get_string(0, 1)->equals("2"), msg);
+    delete df;
+    // the first read by row index adds the rows to the sidecar, keeping its types
+    df = interpret_rows(ints, 1, 1, nullptr);
+    check(df->get_schema().col_type(0) == 'S' && df->nrows() == 1, msg);
+    delete df;
+    idx = load_index(ints);
+    check(idx->has_rows() && idx->nrows_ == 2 && idx->types_[0] == TYPE_STRING, msg);
+
+    // a sidecar with an unknown type is malformed
+    idx->types_[0] = TYPE_STRING + 1;
+    char* str = idx->serialize();
+    check(SorIndex::deserialize(str) == nullptr, msg);
+    delete[] str;
+    delete idx;
+    unlink("index_types.sor.idx");
+    unlink(ints);
+
+    // a small stride so the reads below jump into the middle of the file
+    idx = build_index("1.sor", 2);
+    save_index(idx, "1.sor");
+    DataFrame* all = interpret_file("1.sor", 0, 0);
+    check(idx->nrows_ == all->nrows(), msg);
+    check(idx->offsets_.size() == (all->nrows() + 1) / 2, msg);
+    delete idx;
+
+    idx = load_index("1.sor");
+    check(idx != nullptr && idx->stride_ == 2 && idx->nrows_ == all->nrows(), msg);
+    check(idx->types_.size() == 1 && idx->types_[0] == TYPE_STRING, msg);
+    delete idx;
+
+    // reading 3 rows at a time reproduces the whole file
+    size_t row = 0;
+    for (size_t first = 0; first < all->nrows() + 3; first += 3) {
+        DataFrame* df = interpret_rows("1.sor", first, 3, nullptr);
+        check(df->ncols() == 1, msg);
+        for (size_t r = 0; r < df->nrows(); ++r, ++row) {
+            check(df->get_string(0, r)->equals(all->get_string(0, row)), msg);
+        }
+        delete df;
+    }
+    check(row == all->nrows(), msg);
+
+    // a sidecar is ignored once the file was modified
+    struct timespec times[2] = {{0, UTIME_OMIT}, {1, 0}};
+    struct stat st;
+    check(stat("1.sor", &st) == 0, msg);
+    check(utimensat(AT_FDCWD, "1.sor", times, 0) == 0, msg);
+    check(load_index("1.sor") == nullptr, msg);
+    times[1] = st.st_mtim;
+    check(utimensat(AT_FDCWD, "1.sor", times, 0) == 0, msg);
+
+    delete all;
+    unlink("1.sor.idx");
+
+    puts("Test Index Passed");
+}
+
+// tests reading a file in batches with a bounded number of rows
+void testReader() {
+    const char* msg = "Test Reader Failed";
+    DataFrame* all = interpret_file("1.sor", 0, 0);
+    SorReader reader("1.sor", nullptr, nullptr, 2);
+    size_t row = 0;
+    size_t batches = 0;
+    DataFrame* df;
+    while ((df = reader.next()) != nullptr) {
+        check(df->nrows() == 2 || row + df->nrows() == all->nrows(), msg);
+        for (size_t r = 0; r < df->nrows(); ++r, ++row) {
+            check(df->get_string(0, r)->equals(all->get_string(0, row)), msg);
+        }
+        delete df;
+        batches++;
+    }
+    check(row == all->nrows() && batches == (all->nrows() + 1) / 2, msg);
+    check(reader.next() == nullptr, msg);
+    delete all;
+
+    // filters apply to every batch
+    WordFilter wf;
+    SorReader filtered("1.sor", nullptr, &wf, 1);
+    row = 0;
+    while ((df = filtered.next()) != nullptr) {
+        check(df->nrows() == 1, msg);
+        row++;
+        delete df;
+    }
+    check(row == 5, msg);
+
+    // a file with several types and missing values
+    DataFrame* two = interpret_file("2.sor", 0, 0);
+    SorReader mixed("2.sor", nullptr, nullptr, 100);
+    df = mixed.next();
+    check(df->nrows() == two->nrows() && df->ncols() == 4, msg);
+    for (size_t r = 0; r < df->nrows(); ++r) {
+        check(df->get_bool(0, r) == two->get_bool(0, r), msg);
+        check(df->get_int(1, r) == two->get_int(1, r), msg);
+        check(df->get_string(3, r)->equals(two->get_string(3, r)), msg);
+    }
+    check(mixed.next() == nullptr, msg);
+    delete df;
+    delete two;
+
+    puts("Test Reader Passed");
+}
+
 int main() {
     test0();
     test1();
@@ -98,6 +403,12 @@ int main() {
     // test3(); 3.sor does not fit into size limit on handin server
     // TODO to run this test, redownload from 3.sor piazza post
     test4();
+    testFilter();
+    testRanges();
+    testBinary();
+    testBinaryCorrupt();
+    testIndex();
+    testReader();
 
     return 0;
 }
@@ -12,6 +12,7 @@
 #include <string.h>
 #include "./serialization/message.h"
 #include "../util/string.h"
+#include "../util/thread.h"
 #define PORT 8080
 
 const bool DEBUG = false; // true if you want to print debug messages
@@ -24,14 +25,17 @@ class Socket : public Object {
         int sock_;
         bool closed_; // flag that determines if this socket is closed
         bool active_; // flag that marks if this socket is active (has a message to read)
-        char read_[SIZE]; // string buffer that contains partially read messages
+        char read_[SIZE]; // bytes read from the socket that are not part of a returned message yet
+        size_t read_len_; // number of bytes in read_
+        Lock send_lock_; // held while a message is sent, so messages from different threads
+                         // are never interleaved
 
         // wraps the given socket fd
         Socket(int sock) : Object() {
             sock_ = sock;
             closed_ = false;
             active_ = false;
-            read_[0] = '\0';
+            read_len_ = 0;
         }
 
         // deconstructor
@@ -118,37 +122,55 @@ class Socket : public Object {
         }
         
         // send message over this socket
+        // can be called from several threads at once
         void send_msg(Message* msg) {
             check(!closed_, "Cannot send message on closed socket");
             char* sm = msg->serialize();
             if (DEBUG) printf("Sent: %s", sm);
-            check(send(sock_, sm, strlen(sm), 0) >= 0, "Send failed");
+            size_t len = strlen(sm);
+            send_lock_.lock();
+            // send may write only part of a large message
+            for (size_t sent = 0; sent < len; ) {
+                ssize_t ret = send(sock_, sm + sent, len - sent, 0);
+                check(ret >= 0, "Send failed");
+                sent += ret;
+            }
+            send_lock_.unlock();
             delete[] sm;
         }
         
         // reads a message from this socket
-        // returns nullptr if it couldn't read a full message
+        // blocks until a full message has been read
+        // only the listening thread of a node reads, so reads are not locked
         Message* read_msg() {
             check(!closed_, "Cannot receive message from closed socket");
             // we're using a string buffer to handle a variable size array
-            // user read_ instead of sb
             StrBuff* sb = new StrBuff();
 
+            bool esc = false; // true if the previous character was an unescaped ESC
             bool msg_done = false;
             while (! msg_done) {
-                int idx = index_of(read_, EOM, true); // ignores escaped EOMs
-                if (idx < 0) {
-                    sb->c(read_);
-                    memset(read_, '\0', SIZE * sizeof(char));
-                    int chars_read = read(sock_, read_, SIZE - 1);
-                    check(chars_read >= 0, "Invalid Message read");
+                if (read_len_ == 0) {
+                    int chars_read = read(sock_, read_, SIZE);
+                    check(chars_read > 0, "Invalid Message read");
+                    read_len_ = chars_read;
+                }
+                // find the first EOM that is not escaped, escapes may span two reads
+                size_t idx = 0;
+                for (; idx < read_len_; ++idx) {
+                    if (esc) esc = false;
+                    else if (read_[idx] == ESC) esc = true;
+                    else if (read_[idx] == EOM) break;
+                }
+                if (idx == read_len_) {
+                    sb->c(read_, read_len_);
+                    read_len_ = 0;
                 } else {
-                    // store first part up to EOM in sb
-                    read_[idx] = '\0'; // overwrite EOM with '\0'
-                    sb->c(read_); // concat read_ up to idx
-                    sb->c(EOM); // concat on overwritten EOM
-                    // copy rest to start of read_
-                    memcpy(read_, &(read_[idx+1]), strlen(&(read_[idx+1])) + 1);
+                    // store first part up to and including EOM in sb
+                    sb->c(read_, idx + 1);
+                    // move the rest to the start of read_
+                    read_len_ -= idx + 1;
+                    memmove(read_, &(read_[idx+1]), read_len_);
                     msg_done = true;
                 }
             }
@@ -157,8 +179,7 @@ class Socket : public Object {
             if (DEBUG) printf("Recv: %s", tmp);
             Message* out = Message::deserialize(tmp);
 
-            if (read_[0] == '\0') active_ = false;
-            else active_ = true;
+            active_ = read_len_ > 0;
 
             delete sb;
             delete[] tmp;
@@ -1,6 +1,8 @@
 // Authors: Zoe Corning (corning.z@husky.neu.edu) & Rucha Khanolkar (khanolkar.r@husky.neu.edu)
 #pragma once
 
+#include <deque>
+#include <vector>
 #include "network.h"
 #include "../util/helper.h"
 #include "../util/thread.h"
@@ -8,42 +10,177 @@
 #include "../data/dataframe/dataframe.h"
 #include "../data/kv_store/key.h"
 #include "../data/kv_store/kv_store.h"
+#include "../data/kv_store/future.h"
 
-// thread used for wait and get
-class WaitThread : public Thread {
+// answers a WaitGet request once its key is put into the local store
+// no thread waits for the key, the put of the key sends the reply
+// the value is pinned until the reply is sent (see Future::pin_)
+// deletes itself (and the request) once the reply is sent
+class ReplyFuture : public Future {
     public:
-        WaitGet* wg_; // message to handle once the wait finishes
-        Socket* sock_; // socket to send response to
-        KVStore* kvs_; // store to wait on
-        bool done_; // set to true when response message is sent
-
-        // creates a wait thread to wait for the response to the following message
-        // Note: given message is now owned
-        WaitThread(WaitGet* w, Socket* s, KVStore* kvs) : Thread() {
+        WaitGet* wg_; // owned, the request to answer
+        Socket* sock_; // socket to send the reply to - not owned
+        KVStore* kvs_; // store the value is released in - not owned
+
+        // answers the given request over the given socket
+        ReplyFuture(WaitGet* w, Socket* s, KVStore* kvs) : Future() {
             wg_ = w;
             sock_ = s;
             kvs_ = kvs;
-            done_ = 0;
+            pin_ = true;
         }
 
-        // nothing is owned so no deletion in deconstructor
-        ~WaitThread() {
-            delete wg_->key_; 
+        ~ReplyFuture() {
+            delete wg_->key_;
             delete wg_;
         }
-        
-        // runs the thread
-        void run() {
-            // wait in kvstore
-            DataFrame* df = kvs_->wait_and_get(wg_->key_);
-            // create and send response message
-            GetReply* r = new GetReply(wg_->sender_, wg_->key_, df);
+
+        // sends the value of the key back to the node that asked for it
+        void complete(DataFrame* v) {
+            GetReply* r = new GetReply(wg_->sender_, wg_->key_, v, wg_->id_);
+            sock_->send_msg(r);
+            delete r;
+            kvs_->release_(wg_->key_, v);
+            delete this;
+        }
+};
+
+class ManyWait;
+
+// waits for one key of a WaitGetMany request and hands its value to the request
+class SlotFuture : public Future {
+    public:
+        ManyWait* wait_; // request the key belongs to - not owned
+        size_t slot_; // index of the key in the request
+
+        SlotFuture(ManyWait* wait, size_t slot) : Future() {
+            wait_ = wait;
+            slot_ = slot;
+            pin_ = true; // released by the request once its reply is sent
+        }
+
+        // passes the value to the request, which may delete this future
+        void complete(DataFrame* v);
+};
+
+// answers a WaitGetMany request once every key in it has been put into the local store
+// no thread waits for the keys, the put of the last missing key sends the reply
+// deletes itself (and the request) once the reply is sent
+class ManyWait : public Object {
+    public:
+        GetMany* req_; // owned, keys are owned through it
+        Socket* sock_; // socket to send the reply to - not owned
+        KVStore* kvs_; // store the values are released in once the reply is sent - not owned
+        DataFrame** vals_; // owned array, value of each key of the request
+        SlotFuture** futures_; // owned, one per key
+        size_t left_; // number of keys that are not in the store yet
+        Lock lock_; // lock for vals_ and left_
+
+        // creates the futures for the given request, the reply is sent over the given socket
+        ManyWait(GetMany* req, Socket* sock) : Object() {
+            req_ = req;
+            sock_ = sock;
+            kvs_ = nullptr;
+            left_ = req->size_;
+            vals_ = new DataFrame*[left_];
+            futures_ = new SlotFuture*[left_];
+            for (size_t i = 0; i < left_; ++i) futures_[i] = new SlotFuture(this, i);
+        }
+
+        ~ManyWait() {
+            for (size_t i = 0; i < req_->size_; ++i) delete futures_[i];
+            delete[] futures_;
+            delete[] vals_;
+            req_->delete_data();
+            delete req_;
+        }
+
+        // waits for every key of the request in the given store
+        // this may be deleted by the time this returns
+        void start(KVStore* kvs) {
+            kvs_ = kvs;
+            size_t n = req_->size_;
+            SlotFuture** futures = futures_;
+            Key** keys = req_->keys_;
+            for (size_t i = 0; i < n; ++i) kvs->when_present(keys[i], futures[i]);
+        }
+
+        // sets the value of the key at the given index of the request
+        // sends the reply and deletes this once all the values are set
+        void fill(size_t slot, DataFrame* v) {
+            lock_.lock();
+            vals_[slot] = v;
+            bool done = --left_ == 0;
+            lock_.unlock();
+            if (! done) return;
+            GetManyReply* r = new GetManyReply(req_->target_, req_->sender_, req_->size_,
+                    req_->keys_, vals_, req_->id_);
             sock_->send_msg(r);
             delete r;
-            done_ = true;
+            for (size_t i = 0; i < req_->size_; ++i) kvs_->release_(req_->keys_[i], vals_[i]);
+            delete this;
+        }
+};
+
+void SlotFuture::complete(DataFrame* v) { wait_->fill(slot_, v); }
+
+// waits for the reply to a GetMany or WaitGetMany request sent to one node
+// the listener copies the values of the reply into the caller's array before completing it
+class ManyFuture : public Future {
+    public:
+        DataFrame** out_; // array the values are copied into - not owned
+        std::vector<size_t>* slots_; // index in out_ of each key of the request - not owned
+
+        ManyFuture(DataFrame** out, std::vector<size_t>* slots) : Future() {
+            out_ = out;
+            slots_ = slots;
+        }
+
+        // copies the values of the given reply into out_, then completes this future
+        // deletes the keys of the reply
+        void fill(GetManyReply* r) {
+            check(r->size_ == slots_->size(), "Node: Mismatched reply");
+            for (size_t j = 0; j < r->size_; ++j) {
+                out_[(*slots_)[j]] = r->vals_[j];
+                delete r->keys_[j];
+            }
+            complete(nullptr);
         }
 };
 
+class Node;
+
+// runs the rowers of the Execute requests a node receives on a thread of its own, in the order
+// they arrive, so a long rower does not hold up the listener and the messages behind it
+class Executor : public Thread {
+    public:
+        Node* node_; // node that received the requests and sends the replies - not owned
+        std::deque<Execute*> queue_; // owned, the requests that have not been run yet
+        bool stop_; // true once the node adds no more requests
+        Lock lock_; // lock for queue_ and stop_, the thread waits on it for requests
+
+        Executor(Node* node) : Thread(), node_(node), stop_(false) { }
+
+        // runs the given request once the ones before it are done
+        void add(Execute* e) {
+            lock_.lock();
+            queue_.push_back(e);
+            lock_.notify_all();
+            lock_.unlock();
+        }
+
+        // runs the requests that were added, then ends the thread and waits for it
+        void stop() {
+            lock_.lock();
+            stop_ = true;
+            lock_.notify_all();
+            lock_.unlock();
+            join();
+        }
+
+        void run();
+};
+
 // class that handles setting up and usage of a node in the network
 class Node : public Object {
     public:
@@ -54,11 +191,19 @@ class Node : public Object {
         int idx_; // index of this node - set when Directory is recieved
         KVStore* kvs_;
         
-        GetReply* reply_; // stores the most recent reply for get
-        Lock* r_lock_; // lock for reply
+        RequestTable* pending_; // futures of the remote gets that have not been answered yet
+        Lock* r_lock_; // lock for pending_
+        // values sent to this node by collectives, keyed by collective name and sending node
+        // each one is taken out by the collective that waits for it
+        KVShard* inbox_;
+        size_t epoch_; // number of barriers this node has passed
+        // barrier signals received but not used yet, by round, for the current barrier and the
+        // next one (by epoch parity) - no node can get further ahead than the next barrier
+        size_t arrived_[2][BARRIER_ROUNDS];
+        Lock* b_lock_; // lock for arrived_, barrier() waits on it
 
-        WaitThread** wts_; // threads waiting for wait_and_get - joined on teardown
         std::thread listener_;
+        Executor* executor_; // owned, runs the rowers of Execute requests until teardown
 
         bool teardown_; // true if teardown is in progress
         
@@ -66,26 +211,32 @@ class Node : public Object {
         Node(const char* addr, KVStore* kvs) {
             Message::copy_ip_(addr_, addr);
             idx_ = UIDX;
-            reply_ = nullptr;
+            pending_ = new RequestTable();
             r_lock_ = new Lock();
+            inbox_ = new KVShard();
+            epoch_ = 0;
+            memset(arrived_, 0, sizeof(arrived_));
+            b_lock_ = new Lock();
             kvs_ = kvs;
+            executor_ = new Executor(this);
             teardown_ = false;
         }
 
-        // deconstructor cleans up all threads and cleans up fields
+        // deconstructor tells the server this node is done, waits for the teardown of the network
+        // (see teardown_all) and cleans up fields
         ~Node() {
+            Done* d = new Done(idx_);
+            serv_->send_msg(d);
+            delete d;
             listener_.join();
-            for (size_t i = 0; i < num_nodes_; ++i) {
-                if (wts_[i] != nullptr) {
-                    wts_[i]->join();
-                    delete wts_[i];
-                }
-            }
-            delete[] wts_;
             for (size_t i = 0; i < num_nodes_; ++i) delete nodes_[i];
             delete[] nodes_;
             delete serv_;
             delete r_lock_;
+            delete pending_;
+            delete inbox_;
+            delete b_lock_;
+            delete executor_;
         }
     
         // constructor that constructs a node with a null kvs
@@ -118,8 +269,6 @@ class Node : public Object {
             // set num_nodes based on directory's size
             num_nodes_ = dir->size();
             nodes_ = new Socket*[num_nodes_];
-            wts_ = new WaitThread*[num_nodes_];
-            memset(wts_, 0, num_nodes_ * sizeof(WaitThread*));
             // set this socket to nullptr
             nodes_[idx_] = nullptr;
 
@@ -202,8 +351,11 @@ class Node : public Object {
                     check(g != nullptr, "Node: Cast failed");
                     check(g->key_->idx_ == idx_, "Node: Mismatched indices");
                     
-                    GetReply* gr = new GetReply(g->sender_, g->key_, kvs_->get(g->key_));
+                    // the value is pinned until it is serialized (see KVShard and SpillStore)
+                    DataFrame* v = kvs_->get_local_(g->key_);
+                    GetReply* gr = new GetReply(g->sender_, g->key_, v, g->id_);
                     send_to_node(gr);
+                    if (v != nullptr) kvs_->release_(g->key_, v);
 
                     delete g->key_;
                     delete g;
@@ -212,31 +364,164 @@ class Node : public Object {
                     WaitGet* w = dynamic_cast<WaitGet*>(m);
                     check(w != nullptr, "Node: Cast failed");
                     check(w->key_->idx_ == idx_, "Node: Mismatched indices");
-                    
-                    int is = w->sender_;
 
-                    if (wts_[is] == nullptr || wts_[is]->done_) {
-                        if (wts_[is] != nullptr) {
-                            wts_[is]->join();
-                            delete wts_[is];
-                            wts_[is] = nullptr;
-                        }
-                        wts_[is] = new WaitThread(w, nodes_[is], kvs_);
-                        wts_[is]->start();
-                    }
-                    // else ignore message - node is already waiting for another key
+                    // replies once the key is put (right away if it is already there), deletes
+                    // itself and the message
+                    kvs_->when_present(w->key_, new ReplyFuture(w, nodes_[w->sender_], kvs_));
                 } else if (k == MsgKind::GetReply) {
                     GetReply* r = dynamic_cast<GetReply*>(m);
                     check(r != nullptr, "Node: Cast failed");
                     check(r->target_ == idx_, "Node: Mismatched indices");
 
                     r_lock_->lock();
-                    while (reply_ != nullptr) {
-                        r_lock_->wait();
+                    Future* f = pending_->take(r->id_);
+                    r_lock_->unlock();
+                    check(f != nullptr, "Node: Unexpected reply");
+
+                    DataFrame* df = r->df_;
+                    delete r->key_;
+                    delete r;
+                    f->complete(df);
+                } else if (k == MsgKind::PutMany) {
+                    PutMany* p = dynamic_cast<PutMany*>(m);
+                    check(p != nullptr, "Node: Cast failed");
+                    for (size_t i = 0; i < p->size_; ++i) {
+                        check(p->keys_[i]->idx_ == idx_, "Node: Mismatched indices");
+                        kvs_->put(p->keys_[i], p->vals_[i]);
+                    }
+                    delete p; // don't want to delete keys/vals, stored locally
+                } else if (k == MsgKind::MergeMany) {
+                    MergeMany* mm = dynamic_cast<MergeMany*>(m);
+                    check(mm != nullptr, "Node: Cast failed");
+                    for (size_t i = 0; i < mm->size_; ++i) {
+                        check(mm->keys_[i]->idx_ == idx_, "Node: Mismatched indices");
+                        kvs_->merge(mm->keys_[i], mm->op_, mm->vals_[i]);
+                    }
+                    mm->delete_data(); // merges keep copies
+                    delete mm;
+                } else if (k == MsgKind::Remove) {
+                    Remove* r = dynamic_cast<Remove*>(m);
+                    check(r != nullptr, "Node: Cast failed");
+                    for (size_t i = 0; i < r->size_; ++i) {
+                        check(r->keys_[i]->idx_ == idx_, "Node: Mismatched indices");
+                        if (r->prefix_) kvs_->remove_local_prefix_(r->keys_[i]->str_);
+                        else kvs_->remove_local_(r->keys_[i]);
+                    }
+                    r->delete_data(); // the stored keys are removed, not these
+                    delete r;
+                } else if (k == MsgKind::Scan) {
+                    Scan* sc = dynamic_cast<Scan*>(m);
+                    check(sc != nullptr, "Node: Cast failed");
+                    check(sc->prefix_->idx_ == idx_, "Node: Mismatched indices");
+                    // the keys come from the ordered indexes of the shards, the table is not walked
+                    std::vector<Key*> keys;
+                    kvs_->scan_local(sc->prefix_->str_,
+                            sc->after_ == nullptr ? nullptr : sc->after_->str_, sc->max_, keys);
+                    std::vector<DataFrame*> vals(keys.size(), nullptr);
+                    if (sc->values_) {
+                        for (size_t i = 0; i < keys.size(); ++i) {
+                            vals[i] = kvs_->get_local_(keys[i]);
+                        }
+                    }
+                    ScanReply* r = new ScanReply(idx_, sc->sender_, keys.size(), keys.data(),
+                            vals.data(), sc->id_);
+                    send_to_node(r);
+                    for (size_t i = 0; i < keys.size(); ++i) {
+                        if (vals[i] != nullptr) kvs_->release_(keys[i], vals[i]);
+                    }
+
+                    delete r; // vals are stored locally
+                    for (Key* key : keys) delete key;
+                    delete sc->prefix_;
+                    delete sc->after_;
+                    delete sc;
+                } else if (k == MsgKind::ScanReply) {
+                    ScanReply* r = dynamic_cast<ScanReply*>(m);
+                    check(r != nullptr, "Node: Cast failed");
+                    check(r->target_ == idx_, "Node: Mismatched indices");
+
+                    r_lock_->lock();
+                    ScanFuture* f = dynamic_cast<ScanFuture*>(pending_->take(r->id_));
+                    r_lock_->unlock();
+                    check(f != nullptr, "Node: Unexpected reply");
+                    // the future takes the keys and values of the reply
+                    f->keys_.assign(r->keys_, r->keys_ + r->size_);
+                    f->vals_.assign(r->vals_, r->vals_ + r->size_);
+                    f->owns_vals_ = true;
+                    delete r;
+                    f->complete(nullptr);
+                } else if (k == MsgKind::Broadcast) {
+                    Broadcast* b = dynamic_cast<Broadcast*>(m);
+                    check(b != nullptr, "Node: Cast failed");
+                    // pass the value on first, so the nodes below this one do not wait for it
+                    // to be deserialized here
+                    forward_(b);
+                    Key* root_k = b->key();
+                    check(root_k->idx_ == b->root_, "Node: Mismatched indices");
+                    // every node keeps its copy under the same key with its own index
+                    Key* local_k = new Key(root_k->str_, idx_);
+                    kvs_->put(local_k, b->value());
+                    delete root_k;
+                    delete b;
+                } else if (k == MsgKind::Collect) {
+                    Collect* c = dynamic_cast<Collect*>(m);
+                    check(c != nullptr, "Node: Cast failed");
+                    for (size_t i = 0; i < c->size_; ++i) inbox_->put(c->keys_[i], c->vals_[i]);
+                    delete c; // don't want to delete keys/vals, stored in the inbox
+                } else if (k == MsgKind::Barrier) {
+                    Barrier* b = dynamic_cast<Barrier*>(m);
+                    check(b != nullptr, "Node: Cast failed");
+                    b_lock_->lock();
+                    ++arrived_[b->epoch_ % 2][b->round_];
+                    b_lock_->notify_all();
+                    b_lock_->unlock();
+                    delete b;
+                } else if (k == MsgKind::Execute) {
+                    Execute* e = dynamic_cast<Execute*>(m);
+                    check(e != nullptr, "Node: Cast failed");
+                    check(e->key_->idx_ == idx_, "Node: Mismatched indices");
+                    // the executor is stopped once teardown starts
+                    if (teardown_) execute_(e);
+                    else executor_->add(e);
+                } else if (k == MsgKind::GetMany) {
+                    GetMany* g = dynamic_cast<GetMany*>(m);
+                    check(g != nullptr, "Node: Cast failed");
+                    DataFrame** vals = new DataFrame*[g->size_];
+                    for (size_t i = 0; i < g->size_; ++i) {
+                        check(g->keys_[i]->idx_ == idx_, "Node: Mismatched indices");
+                        vals[i] = kvs_->get_local_(g->keys_[i]);
                     }
-                    reply_ = r;
+                    GetManyReply* gr = new GetManyReply(idx_, g->sender_, g->size_, g->keys_, vals,
+                            g->id_);
+                    send_to_node(gr);
+                    for (size_t i = 0; i < g->size_; ++i) {
+                        if (vals[i] != nullptr) kvs_->release_(g->keys_[i], vals[i]);
+                    }
+
+                    g->delete_data();
+                    delete g;
+                    delete gr; // keys are the same as g's, vals are stored locally
+                    delete[] vals;
+                } else if (k == MsgKind::WaitGetMany) {
+                    GetMany* g = dynamic_cast<GetMany*>(m);
+                    check(g != nullptr, "Node: Cast failed");
+                    for (size_t i = 0; i < g->size_; ++i) {
+                        check(g->keys_[i]->idx_ == idx_, "Node: Mismatched indices");
+                    }
+                    // replies once the last key is put, deletes itself and the message
+                    ManyWait* mw = new ManyWait(g, nodes_[g->sender_]);
+                    mw->start(kvs_);
+                } else if (k == MsgKind::GetManyReply) {
+                    GetManyReply* r = dynamic_cast<GetManyReply*>(m);
+                    check(r != nullptr, "Node: Cast failed");
+                    check(r->target_ == idx_, "Node: Mismatched indices");
+
+                    r_lock_->lock();
+                    ManyFuture* f = dynamic_cast<ManyFuture*>(pending_->take(r->id_));
                     r_lock_->unlock();
-                    r_lock_->notify_all();
+                    check(f != nullptr, "Node: Unexpected reply");
+                    f->fill(r);
+                    delete r;
                 } else if (k == MsgKind::Kill) {
                     // gets kill message from another node before server message
                     nodes_[m->sender_]->close_sock(); // close connection with that node
@@ -282,6 +567,7 @@ class Node : public Object {
 
             // start listening thread
             listener_ = std::thread([this]{ this->handle_incoming_(); });
+            executor_->start();
             
             return idx_;
         }
@@ -299,6 +585,8 @@ class Node : public Object {
         }
 
         // starts teardown for entire kvstore/network
+        // the server only sends the Kill messages once every node is deleted (and so done sending
+        // messages), so a node may still be in a collective with the others when this is called
         void teardown_all() {
             Kill* k = new Kill(idx_, SIDX);
             serv_->send_msg(k);
@@ -307,19 +595,18 @@ class Node : public Object {
 
         // tears down this node - private method
         // this method should only be called when kill received from server
+        // the messages other nodes sent before they were done may still be on their way (ex. the
+        // last signals of a barrier or values of a collective), so they are handled until each
+        // connection is closed instead of being dropped
         void teardown_node_() {
             teardown_ = true; // teardown has started
+            executor_->stop(); // sends the results of the rowers still to run
             handle_active_(); // handle active messages that have to be read
             serv_->close_sock(); // close server connection
             printf("Node %d: closed server connection\n", idx_);
-            // recv kill and close all nodes before in list
+            // handle messages up to the kill of each node before in list, which closes the socket
             for (int i = 0; i < idx_; ++i) {
-                if (nodes_[i]->is_closed()) continue;
-                else {
-                    Kill* k = dynamic_cast<Kill*>(nodes_[i]->read_msg());
-                    nodes_[i]->close_sock();
-                    delete k;
-                }
+                while (! nodes_[i]->closed_) handle_message_(nodes_[i]->read_msg());
             }
             // send kill to all nodes with greater idx in list
             Kill* k2 = new Kill(idx_, SIDX);
@@ -329,13 +616,40 @@ class Node : public Object {
             }
             delete k2;
             // make sure all connections are closed
-            for (size_t i = idx_+1; i < num_nodes_; ++i) nodes_[i]->wait_for_close();
+            for (size_t i = idx_+1; i < num_nodes_; ++i) drain_(i);
             
             // clean up KVStore memory
             // has to be done here, when we know teardown is done
             kvs_->delete_all(); 
         }
 
+        // runs the rower of the given request over the value of its key (which stays pinned while
+        // it runs) and sends the result back to the node that asked for it
+        // the rower runs here, next to the value, and only its result is sent back
+        // deletes the request
+        void execute_(Execute* e) {
+            DataFrame* out = kvs_->run_local_(e->key_, e->name_, e->state_);
+            GetReply* gr = new GetReply(e->sender_, e->key_, out, e->id_);
+            send_to_node(gr);
+
+            delete gr; // don't delete gr->key_, same as e->key_
+            delete out;
+            delete e->key_;
+            delete e->state_;
+            delete e;
+        }
+
+        // handles the messages from the node with the given index until it closes its connection
+        void drain_(size_t i) {
+            Socket* s = nodes_[i];
+            while (true) {
+                // blocks until there is a message or the connection is closed
+                if (! s->active_) select_active(1, &s);
+                if (s->read_len_ == 0 && s->is_closed()) return;
+                handle_message_(s->read_msg());
+            }
+        }
+
         // puts the key and dataframe in the local kvstore if possible (if index matches)
         // else sends a Put message to the correct node
         void put(Key* k, DataFrame* v) {
@@ -349,45 +663,385 @@ class Node : public Object {
             }
         }
 
-        // waits for the reply for the get request with the given key
-        DataFrame* wait_for_reply(Key* k) {
-            r_lock_->lock();  
-            while (reply_ == nullptr || !reply_->key_->equals(k)) {
-                r_lock_->wait();
-            }
-            GetReply* r = reply_;
-            reply_ = nullptr;
+        // registers the given future under a new request id and returns the id
+        // the listener completes the future when the reply with that id arrives
+        size_t register_(Future* f) {
+            // register before sending, the reply can arrive before send_to_node returns
+            r_lock_->lock();
+            size_t id = pending_->add(f);
             r_lock_->unlock();
-            r_lock_->notify_all();
+            return id;
+        }
 
-            DataFrame* out = r->df_;
-            delete r->key_;
-            delete r;
+        // sends a Get (or WaitGet if wait is true) for the given remote key
+        // the given future is completed by the listener when the reply arrives
+        void request_(Key* k, Future* f, bool wait) {
+            size_t id = register_(f);
+            if (wait) {
+                WaitGet* w = new WaitGet(idx_, k, id);
+                send_to_node(w);
+                delete w;
+            } else {
+                Get* g = new Get(idx_, k, id);
+                send_to_node(g);
+                delete g;
+            }
+        }
+
+        // puts the given key and dataframe into the kvstore of every node, each under the key
+        // with the same string and that node's index
+        // the value is serialized once and sent down a binomial tree rooted at this node, so no
+        // node sends it more than log2(num_nodes_) times and it reaches every node in about
+        // log2(num_nodes_) hops
+        // @pre the given key is local, it and the dataframe are stored here
+        void broadcast(Key* k, DataFrame* v) {
+            check(k->idx_ == idx_, "Node: Can only broadcast a local key");
+            Broadcast* b = new Broadcast(idx_, k, v);
+            forward_(b);
+            delete b;
+            kvs_->put(k, v);
+        }
+
+        // blocks until every node has called barrier() as many times as this node
+        // dissemination barrier: in round k every node signals node idx + 2^k and waits for the
+        // signal of node idx - 2^k, so after ceil(log2(num_nodes_)) rounds each node has heard
+        // from every other one, directly or through others
+        // nothing is put into the store, each round is one small message per node
+        // NOTE: one-way messages (ex. puts and merges) sent before the barrier can still arrive
+        // after it, since they may take a different connection than the signals
+        void barrier() {
+            size_t parity = epoch_ % 2;
+            size_t round = 0;
+            for (size_t d = 1; d < num_nodes_; d <<= 1, ++round) {
+                Barrier* b = new Barrier(idx_, (idx_ + d) % num_nodes_, epoch_, round);
+                send_to_node(b);
+                delete b;
+                b_lock_->lock();
+                while (arrived_[parity][round] == 0) b_lock_->wait();
+                --arrived_[parity][round];
+                b_lock_->unlock();
+            }
+            ++epoch_;
+        }
+
+        // sends the given broadcast to the children of this node in the broadcast's tree
+        void forward_(Broadcast* b) {
+            b->sender_ = idx_;
+            for (size_t c : children_(rank_(b->root_))) {
+                b->update_target(at_rank_(b->root_, c));
+                send_to_node(b);
+            }
+        }
+
+        // returns the rank of this node in a tree rooted at the given node (the root has rank 0)
+        size_t rank_(int root) { return (idx_ - root + num_nodes_) % num_nodes_; }
+
+        // returns the node with the given rank in a tree rooted at the given node
+        int at_rank_(int root, size_t rank) { return (root + rank) % num_nodes_; }
+
+        // returns the ranks of the children of the given rank in the binomial tree over all nodes
+        // the children of rank r are r + m for each power of 2 m below the lowest set bit of r
+        // (any m for the root), and the subtree of child r + m holds the ranks [r + m, r + 2m)
+        // the biggest subtree comes first
+        std::vector<size_t> children_(size_t rank) {
+            std::vector<size_t> out;
+            size_t m = rank & -rank; // lowest set bit
+            if (rank == 0) {
+                m = 1;
+                while (m < num_nodes_) m <<= 1;
+            }
+            for (m >>= 1; m > 0; m >>= 1) {
+                if (rank + m < num_nodes_) out.push_back(rank + m);
+            }
             return out;
         }
-        
+
+        // returns the rank of the parent of the given rank (> 0) in the binomial tree, which is
+        // the rank without its lowest set bit
+        size_t parent_(size_t rank) { return rank & (rank - 1); }
+
+        // sends the given values to the collective inbox of the given node, each under the given
+        // name and the index of the node it came from (the values stay owned by the caller)
+        void collect_send_(int to, const char* name, int* from, DataFrame** vals, size_t n) {
+            Key** keys = new Key*[n];
+            for (size_t i = 0; i < n; ++i) keys[i] = new Key(name, from[i]);
+            Collect* c = new Collect(idx_, to, n, keys, vals);
+            send_to_node(c);
+            delete c;
+            for (size_t i = 0; i < n; ++i) delete keys[i];
+            delete[] keys;
+        }
+
+        // waits for the value the given node sent for the given collective and takes it out of
+        // the inbox, the value is now owned by the caller
+        DataFrame* collect_take_(const char* name, int from) {
+            Key k(name, from);
+            DataFrame* out = inbox_->wait_and_get(&k);
+            Key* stored = nullptr;
+            inbox_->remove(&k, &stored);
+            delete stored;
+            return out;
+        }
+
+        // gathers the value of every node on the given root, along the binomial tree rooted there
+        // each node sends the values of its whole subtree to its parent in one message, so the
+        // root receives log2(num_nodes_) messages instead of one per node
+        // returns, on the root, an array of num_nodes_ copies (owned by the caller) of the values
+        // by node index, and nullptr on every other node
+        DataFrame** gather(const char* name, DataFrame* v, int root) {
+            size_t rank = rank_(root);
+            // values of this node's subtree by rank, from this rank up
+            std::vector<DataFrame*> sub(1, v->clone());
+            for (size_t c : children_(rank)) {
+                size_t end = c + (c - rank) < num_nodes_ ? c + (c - rank) : num_nodes_;
+                if (sub.size() < end - rank) sub.resize(end - rank, nullptr);
+                for (size_t q = c; q < end; ++q) sub[q - rank] = collect_take_(name, at_rank_(root, q));
+            }
+
+            if (rank == 0) {
+                DataFrame** out = new DataFrame*[num_nodes_];
+                for (size_t q = 0; q < num_nodes_; ++q) out[at_rank_(root, q)] = sub[q];
+                return out;
+            }
+            int* from = new int[sub.size()];
+            for (size_t q = 0; q < sub.size(); ++q) from[q] = at_rank_(root, rank + q);
+            collect_send_(at_rank_(root, parent_(rank)), name, from, sub.data(), sub.size());
+            for (DataFrame* df : sub) delete df;
+            delete[] from;
+            return nullptr;
+        }
+
+        // combines the value of every node with the given operation on the given root, along the
+        // binomial tree rooted there, so no node merges or receives more than log2(num_nodes_)
+        // values
+        // returns the result (owned by the caller) on the root, and nullptr on every other node
+        // @pre the operation is commutative (i.e. not Append)
+        DataFrame* reduce(const char* name, MergeOp op, DataFrame* v, int root) {
+            size_t rank = rank_(root);
+            DataFrame* acc = v->clone();
+            for (size_t c : children_(rank)) {
+                DataFrame* part = collect_take_(name, at_rank_(root, c));
+                merge_into(op, acc, part);
+                delete part;
+            }
+            if (rank == 0) return acc;
+            collect_send_(at_rank_(root, parent_(rank)), name, &idx_, &acc, 1);
+            delete acc;
+            return nullptr;
+        }
+
+        // combines the value of every node with the given operation and returns the result (owned
+        // by the caller) on every node
+        // uses recursive doubling: in each of log2(p) rounds, where p is the biggest power of 2 <=
+        // num_nodes_, every node swaps its partial result with the node whose index differs in
+        // one bit, and the nodes from p up first fold their value into node idx - p and get the
+        // result back from it at the end
+        // @pre the operation is commutative (i.e. not Append)
+        DataFrame* allreduce(const char* name, MergeOp op, DataFrame* v) {
+            size_t me = idx_;
+            size_t p = 1;
+            while (p * 2 <= num_nodes_) p <<= 1;
+            DataFrame* acc = v->clone();
+            if (me >= p) {
+                collect_send_(me - p, name, &idx_, &acc, 1);
+                delete acc;
+                return collect_take_(name, me - p);
+            }
+            DataFrame* part = nullptr;
+            if (me + p < num_nodes_) {
+                part = collect_take_(name, me + p);
+                merge_into(op, acc, part);
+                delete part;
+            }
+            for (size_t m = 1; m < p; m <<= 1) {
+                int partner = me ^ m;
+                collect_send_(partner, name, &idx_, &acc, 1);
+                part = collect_take_(name, partner);
+                merge_into(op, acc, part);
+                delete part;
+            }
+            if (me + p < num_nodes_) collect_send_(me + p, name, &idx_, &acc, 1);
+            return acc;
+        }
+
         // gets the dataframe from the given key in the local kvstore (if index matches)
         // else sends Get message to correct node and waits for a reply
         DataFrame* get(Key* k) {
             if (k->idx_ == idx_) return kvs_->get(k);
-            else {
-                Get* g = new Get(idx_, k);
+            Future f;
+            request_(k, &f, false);
+            return f.get();
+        }
+
+        // completes the given future with the dataframe of the given key (nullptr if it does not exist)
+        // returns right away, a remote key is completed by the listener when the reply arrives
+        void get_async(Key* k, Future* f) {
+            if (k->idx_ == idx_) f->complete(kvs_->get(k));
+            else request_(k, f, false);
+        }
+
+        // completes the given future with the dataframe of the given key once the key exists
+        // returns right away, a remote key may be deleted then, but a local one must stay until the
+        // future is ready
+        void wait_and_get_async(Key* k, Future* f) {
+            if (k->idx_ == idx_) kvs_->when_present(k, f);
+            else request_(k, f, true);
+        }
+
+        // asks the owner of the given remote key to run a rower of the type registered under the
+        // given name, made from the given state, over its value
+        // the given future is completed with the result of the rower by the listener
+        void execute_async(Key* k, const char* name, DataFrame* state, Future* f) {
+            Execute* e = new Execute(idx_, k, name, state, register_(f));
+            send_to_node(e);
+            delete e;
+        }
+
+        // asks the owner of the given remote prefix key for at most max of its keys that start with
+        // the prefix and come after the string of the given key (from the first if after is
+        // nullptr), with their values if values is true
+        // the given future is completed by the listener once the keys have arrived
+        void scan_async(Key* prefix, Key* after, size_t max, bool values, ScanFuture* f) {
+            Scan* sc = new Scan(idx_, prefix, after, max, values, register_(f));
+            send_to_node(sc);
+            delete sc;
+        }
+
+        // puts each key and dataframe in the kvstore of the node the key belongs to
+        // sends one PutMany message to each other node that owns some of the keys
+        void put_many(Key** keys, DataFrame** vals, size_t n) {
+            std::vector<std::vector<size_t>> by_node = group_by_node_(keys, n);
+            for (size_t i = 0; i < num_nodes_; ++i) {
+                std::vector<size_t>& idxs = by_node[i];
+                if (idxs.empty()) continue;
+                if (i == (size_t)idx_) {
+                    for (size_t j : idxs) kvs_->put(keys[j], vals[j]);
+                    continue;
+                }
+                Key** ks = new Key*[idxs.size()];
+                DataFrame** vs = new DataFrame*[idxs.size()];
+                for (size_t j = 0; j < idxs.size(); ++j) {
+                    ks[j] = keys[idxs[j]];
+                    vs[j] = vals[idxs[j]];
+                }
+                PutMany* p = new PutMany(idx_, i, idxs.size(), ks, vs);
+                send_to_node(p);
+                delete p;
+                delete[] ks;
+                delete[] vs;
+            }
+        }
+
+        // applies the given operation to each key with the matching operand on the node that
+        // owns it, sends one MergeMany message to each other node that owns some of the keys
+        void merge_many(Key** keys, MergeOp op, DataFrame** vals, size_t n) {
+            std::vector<std::vector<size_t>> by_node = group_by_node_(keys, n);
+            for (size_t i = 0; i < num_nodes_; ++i) {
+                std::vector<size_t>& idxs = by_node[i];
+                if (idxs.empty()) continue;
+                if (i == (size_t)idx_) {
+                    for (size_t j : idxs) kvs_->merge(keys[j], op, vals[j]);
+                    continue;
+                }
+                Key** ks = new Key*[idxs.size()];
+                DataFrame** vs = new DataFrame*[idxs.size()];
+                for (size_t j = 0; j < idxs.size(); ++j) {
+                    ks[j] = keys[idxs[j]];
+                    vs[j] = vals[idxs[j]];
+                }
+                MergeMany* mm = new MergeMany(idx_, i, op, idxs.size(), ks, vs);
+                send_to_node(mm);
+                delete mm;
+                delete[] ks;
+                delete[] vs;
+            }
+        }
+
+        // removes each of the given keys from the node that owns it, sends one Remove message to
+        // each other node that owns some of the keys, and does not wait for them
+        // if prefix is true, the string of each key is a prefix of the keys to remove on its node
+        void remove_many(Key** keys, size_t n, bool prefix) {
+            std::vector<std::vector<size_t>> by_node = group_by_node_(keys, n);
+            for (size_t i = 0; i < num_nodes_; ++i) {
+                std::vector<size_t>& idxs = by_node[i];
+                if (idxs.empty()) continue;
+                if (i == (size_t)idx_) {
+                    for (size_t j : idxs) {
+                        if (prefix) kvs_->remove_local_prefix_(keys[j]->str_);
+                        else kvs_->remove_local_(keys[j]);
+                    }
+                    continue;
+                }
+                Key** ks = new Key*[idxs.size()];
+                for (size_t j = 0; j < idxs.size(); ++j) ks[j] = keys[idxs[j]];
+                Remove* r = new Remove(idx_, i, idxs.size(), ks, prefix);
+                send_to_node(r);
+                delete r;
+                delete[] ks;
+            }
+        }
+
+        // gets the dataframes of the given keys into out (nullptr for a key that does not exist)
+        // if wait is true, waits until every key exists
+        // sends one request to each other node that owns some of the keys before waiting for any
+        // reply, so the nodes answer in parallel
+        void get_many(Key** keys, size_t n, DataFrame** out, bool wait) {
+            std::vector<std::vector<size_t>> by_node = group_by_node_(keys, n);
+            ManyFuture** futures = new ManyFuture*[num_nodes_];
+            memset(futures, 0, num_nodes_ * sizeof(ManyFuture*));
+            for (size_t i = 0; i < num_nodes_; ++i) {
+                std::vector<size_t>& idxs = by_node[i];
+                if (i == (size_t)idx_ || idxs.empty()) continue;
+                futures[i] = new ManyFuture(out, &idxs);
+                Key** ks = new Key*[idxs.size()];
+                for (size_t j = 0; j < idxs.size(); ++j) ks[j] = keys[idxs[j]];
+                GetMany* g = new GetMany(idx_, i, idxs.size(), ks, wait, register_(futures[i]));
                 send_to_node(g);
                 delete g;
-              
-                return wait_for_reply(k); 
+                delete[] ks;
+            }
+            for (size_t j : by_node[idx_]) {
+                out[j] = wait ? kvs_->wait_and_get(keys[j]) : kvs_->get(keys[j]);
             }
+            for (size_t i = 0; i < num_nodes_; ++i) {
+                if (futures[i] == nullptr) continue;
+                futures[i]->get();
+                delete futures[i];
+            }
+            delete[] futures;
+        }
+
+        // groups the indices of the given keys by the node that owns them
+        std::vector<std::vector<size_t>> group_by_node_(Key** keys, size_t n) {
+            std::vector<std::vector<size_t>> out(num_nodes_);
+            for (size_t i = 0; i < n; ++i) {
+                check(keys[i]->idx_ >= 0 && (size_t)keys[i]->idx_ < num_nodes_,
+                        "Node: Index out of bounds");
+                out[keys[i]->idx_].push_back(i);
+            }
+            return out;
         }
 
         // waits until the given key is in the kvstore to get the corresponding dataframe
         DataFrame* wait_and_get(Key* k) {
             if (k->idx_ == idx_) return kvs_->wait_and_get(k);
-            else {
-                WaitGet* w = new WaitGet(idx_, k);
-                send_to_node(w);
-                delete w;
-            
-                return wait_for_reply(k);
-            }
+            Future f;
+            request_(k, &f, true);
+            return f.get();
         }
 };
+
+void Executor::run() {
+    while (true) {
+        lock_.lock();
+        while (queue_.empty() && ! stop_) lock_.wait();
+        if (queue_.empty()) {
+            lock_.unlock();
+            return;
+        }
+        Execute* e = queue_.front();
+        queue_.pop_front();
+        lock_.unlock();
+        node_->execute_(e);
+    }
+}
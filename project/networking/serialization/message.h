@@ -6,6 +6,7 @@
 #include <netinet/in.h>
 #include <string.h>
 #include "../../data/kv_store/key.h"
+#include "../../data/kv_store/merge.h"
 #include "../../data/dataframe/dataframe.h"
 #include "../../util/object.h"
 #include "../../util/string.h"
@@ -16,9 +17,12 @@ const char EOM = '\n'; // means end of message (if not escaped)
 const int IPLEN = 16; // equal to strlen("111.111.111.111")+1 (i.e. number of chars for an IP)
 const int SIDX = -1; // index used to represent the server
 const int UIDX = -2; // index used to represent a node that has not been registered
+const size_t BARRIER_ROUNDS = 32; // most rounds of a barrier, enough for 2^32 nodes
 
 // enum representing different kinds of messages
-enum class MsgKind { Register, Directory, Open, Connect, Greeting, Put, Get, WaitGet, GetReply, Text, Kill };
+enum class MsgKind { Register, Directory, Open, Connect, Greeting, Put, Get, WaitGet, GetReply, Text, Kill,
+    PutMany, GetMany, WaitGetMany, GetManyReply, MergeMany, Broadcast, Collect, Barrier, Execute,
+    Remove, Scan, ScanReply, Done };
 
 // this is a parent class for messages to be sent over a network
 class Message : public Object {
@@ -86,6 +90,32 @@ class Message : public Object {
                     return const_cast<char*>("Text");
                 case MsgKind::Kill:
                     return const_cast<char*>("Kill");
+                case MsgKind::PutMany:
+                    return const_cast<char*>("PutMany");
+                case MsgKind::GetMany:
+                    return const_cast<char*>("GetMany");
+                case MsgKind::WaitGetMany:
+                    return const_cast<char*>("WaitGetMany");
+                case MsgKind::GetManyReply:
+                    return const_cast<char*>("GetManyReply");
+                case MsgKind::MergeMany:
+                    return const_cast<char*>("MergeMany");
+                case MsgKind::Broadcast:
+                    return const_cast<char*>("Broadcast");
+                case MsgKind::Collect:
+                    return const_cast<char*>("Collect");
+                case MsgKind::Barrier:
+                    return const_cast<char*>("Barrier");
+                case MsgKind::Execute:
+                    return const_cast<char*>("Execute");
+                case MsgKind::Remove:
+                    return const_cast<char*>("Remove");
+                case MsgKind::Scan:
+                    return const_cast<char*>("Scan");
+                case MsgKind::ScanReply:
+                    return const_cast<char*>("ScanReply");
+                case MsgKind::Done:
+                    return const_cast<char*>("Done");
                 default:
                     check(false, "Invalid message type");
                     return nullptr;
@@ -404,142 +434,776 @@ class Put : public Message {
         }
 };
 
-// message sent from one node to another to put in a key
+// message sent from one node to another to get the value of a key
 class Get : public Message {
     public:
         Key* key_;
+        size_t id_; // id of the request, sent back in the GetReply
         
-        Get(int sender, Key* key) : Message(MsgKind::Get, sender, key->idx_) {
+        Get(int sender, Key* key, size_t id) : Message(MsgKind::Get, sender, key->idx_) {
             key_ = key;
+            id_ = id;
         }
 
         // serializes this get message into the following format:
-        // Get <sender_> <target_> {<str> <idx>}\n
+        // Get <sender_> <target_> {<id_> <str> <idx>}\n
         char* serialize() {
-            char* tmp = key_->serialize();
-            char* out = wrap_with_header_(tmp);
+            return serialize_request_(this, key_, id_);
+        }
+
+        // serializes a request for one key with the given id (see format above)
+        static char* serialize_request_(Message* msg, Key* key, size_t id) {
+            StrBuff* sb = new StrBuff();
+            sb->c(id);
+            sb->c(DLM);
+            char* tmp = key->serialize();
+            sb->c(tmp);
+            delete[] tmp;
+
+            tmp = sb->no_cpy_get();
+            char* out = msg->wrap_with_header_(tmp);
             delete[] tmp;
+            delete sb;
             return out;
         }
 
-        // deserializes the given string into a Get message
-        static Get* deserialize(char* m) {
+        // parses a request for one key of the given kind (see format above)
+        // sets the given sender, key and id
+        static void deserialize_request_(char* m, const char* kind, int* sender, Key** key,
+                size_t* id) {
             char* rest = nullptr;
             char* tok = next_token(m, &rest, DLM, false);
-            check(streq(tok, "Get"), "Invalid Get message");
+            check(streq(tok, kind), "Invalid message kind");
             delete[] tok;
 
             tok = next_token(rest, &rest, DLM, false);
-            int sender = atoi(tok);
+            *sender = atoi(tok);
             delete[] tok;
 
             delete[] next_token(rest, &rest, '{', false);
-            tok = next_token(rest, &rest, '}', true); // key handles escapes
-            Key* k = Key::deserialize(tok);
+            tok = next_token(rest, &rest, DLM, false);
+            *id = strtoull(tok, nullptr, 10);
+            delete[] tok;
+            tok = next_token(rest, &rest, '}', false); // key removes escapes when deserializing
+            *key = Key::deserialize(tok);
             delete[] tok;
+        }
 
-            return new Get(sender, k);
+        // deserializes the given string into a Get message
+        static Get* deserialize(char* m) {
+            int sender;
+            Key* k;
+            size_t id;
+            deserialize_request_(m, "Get", &sender, &k, &id);
+            return new Get(sender, k, id);
         }
 };
 
-// message sent from one node to another to put in a key
+// message sent from one node to another to get the value of a key once it exists
 class WaitGet : public Message {
     public:
         Key* key_;
+        size_t id_; // id of the request, sent back in the GetReply
         
-        WaitGet(int sender,  Key* key) : Message(MsgKind::WaitGet, sender, key->idx_) {
+        WaitGet(int sender, Key* key, size_t id) : Message(MsgKind::WaitGet, sender, key->idx_) {
             key_ = key;
+            id_ = id;
         }
 
         // serializes this waitget message into the following format:
-        // WaitGet <sender_> <target_> {<str> <idx>}\n
+        // WaitGet <sender_> <target_> {<id_> <str> <idx>}\n
+        char* serialize() {
+            return Get::serialize_request_(this, key_, id_);
+        }
+
+        // deserializes the given string into a WaitGet message
+        static WaitGet* deserialize(char* m) {
+            int sender;
+            Key* k;
+            size_t id;
+            Get::deserialize_request_(m, "WaitGet", &sender, &k, &id);
+            return new WaitGet(sender, k, id);
+        }
+};
+
+// message sent from one node to another in response to a get request
+class GetReply : public Message {
+    public:
+        Key* key_; // key from the get request
+        DataFrame* df_; // corresponding dataframe (nullptr if the key does not exist)
+        size_t id_; // id of the request this answers
+        
+        // creates a GetReply message with the given target, key, dataframe and request id
+        GetReply(int target, Key* key, DataFrame* df, size_t id)
+                : Message(MsgKind::GetReply, key->idx_, target) {
+            key_ = key;
+            df_ = df;
+            id_ = id;
+        }
+
+        // serializes this GetReply message into the following format:
+        // GetReply <sender_> <target_> {<id_> <str> <idx>|<col_types> <nrows> [...]}\n
+        // a missing dataframe is sent as nothing: {<id_> <str> <idx>|}
         char* serialize() {
+            StrBuff* sb = new StrBuff();
+            sb->c(id_);
+            sb->c(DLM);
             char* tmp = key_->serialize();
+            sb->c(tmp);
+            delete[] tmp;
+
+            sb->c('|');
+            if (df_ != nullptr) {
+                tmp = df_->serialize();
+                sb->c(tmp);
+                delete[] tmp;
+            }
+
+            tmp = sb->no_cpy_get();
+            char* out = wrap_with_header_(tmp); // don't want to use get(), extra dup
+            delete[] tmp;
+            delete sb;
+            return out;
+        }
+
+        static GetReply* deserialize(char* m) {
+            char* rest = nullptr;
+            char* tok = next_token(m, &rest, DLM, false);
+            check(streq(tok, "GetReply"), "Invalid GetReply message");
+            delete[] tok;
+
+            // skip the sender
+            delete[] next_token(rest, &rest, DLM, false);
+
+            tok = next_token(rest, &rest, DLM, false);
+            int target = atoi(tok);
+            delete[] tok;
+
+            // skip to inside of brackets
+            delete[] next_token(rest, &rest, '{', false);
+            tok = next_token(rest, &rest, DLM, false);
+            size_t id = strtoull(tok, nullptr, 10);
+            delete[] tok;
+            tok = next_token(rest, &rest, '|', false); // key removes escapes when deserializing
+            Key* k = Key::deserialize(tok);
+            delete[] tok;
+
+            tok = next_token(rest, &rest, '}', false); // dataframe removes escapes
+            DataFrame* d = tok[0] == '\0' ? nullptr : DataFrame::deserialize(tok);
+            delete[] tok;
+
+            return new GetReply(target, k, d, id);
+        }
+};
+
+
+// parent class for messages that carry several keys for the same node, and possibly a
+// DataFrame for each of them (used to batch many puts or gets into one message)
+// the arrays are owned, the keys and DataFrames are not
+class ManyMessage : public Message {
+    public:
+        size_t size_; // number of keys
+        Key** keys_; // keys in this message
+        DataFrame** vals_; // value of each key (nullptr if missing), or nullptr if only keys are sent
+        // id of the request (a request and its reply share it), 0 for a PutMany, a MergeMany and
+        // a Remove, since none of them is answered
+        size_t id_;
+
+        // creates a message with a copy of the given arrays (vals may be nullptr)
+        ManyMessage(MsgKind kind, int sender, int target, size_t size, Key** keys, DataFrame** vals,
+                size_t id) : Message(kind, sender, target) {
+            id_ = id;
+            size_ = size;
+            keys_ = new Key*[size];
+            // the arrays of an empty message may be nullptr (ex. the data of an empty vector)
+            if (size > 0) memcpy(keys_, keys, size * sizeof(Key*));
+            vals_ = nullptr;
+            if (vals != nullptr) {
+                vals_ = new DataFrame*[size];
+                if (size > 0) memcpy(vals_, vals, size * sizeof(DataFrame*));
+            }
+        }
+
+        // deletes the arrays, but not the keys and values
+        ~ManyMessage() {
+            delete[] keys_;
+            delete[] vals_;
+        }
+
+        // deletes the keys and values of this message (ex. once a deserialized message is handled)
+        void delete_data() {
+            for (size_t i = 0; i < size_; ++i) {
+                delete keys_[i];
+                if (vals_ != nullptr) delete vals_[i];
+            }
+        }
+
+        // serializes this message into the following format:
+        // <kind_> <sender_> <target_> {<id_> <size_> {<str> <idx>|<col_types> <nrows> [...]} {...}}\n
+        // without values, each key is sent as {<str> <idx>}
+        // a missing value is sent as nothing: {<str> <idx>|}
+        // a subclass with a field of its own sends it first, see serialize_head_
+        char* serialize() {
+            StrBuff* sb = new StrBuff();
+            serialize_head_(sb);
+            sb->c(id_);
+            sb->c(DLM);
+            sb->c(size_);
+            for (size_t i = 0; i < size_; ++i) {
+                sb->c(" {");
+                char* tmp = keys_[i]->serialize();
+                sb->c(tmp);
+                delete[] tmp;
+                if (vals_ != nullptr) {
+                    sb->c('|');
+                    if (vals_[i] != nullptr) {
+                        tmp = vals_[i]->serialize();
+                        sb->c(tmp);
+                        delete[] tmp;
+                    }
+                }
+                sb->c('}');
+            }
+            char* tmp = sb->no_cpy_get();
             char* out = wrap_with_header_(tmp);
             delete[] tmp;
+            delete sb;
             return out;
         }
 
-        // deserializes the given string into a WaitGet message
-        static WaitGet* deserialize(char* m) {
+        // adds the fields of a subclass that go before the id, followed by a space (none here)
+        virtual void serialize_head_(StrBuff* sb) { }
+
+        // parses the header and body of the given serialized message of the given kind
+        // sets the given sender, target, id, size and keys, and the values if vals is not nullptr
+        // if head is not nullptr, the message has a field before the id (see serialize_head_),
+        // which is parsed into it
+        static void deserialize_many_(char* m, const char* kind, int* sender, int* target,
+                size_t* id, size_t* size, Key*** keys, DataFrame*** vals, size_t* head = nullptr) {
+            char* rest = nullptr;
+            char* tok = next_token(m, &rest, DLM, false);
+            check(streq(tok, kind), "Invalid message kind");
+            delete[] tok;
+
+            tok = next_token(rest, &rest, DLM, false);
+            *sender = atoi(tok);
+            delete[] tok;
+            tok = next_token(rest, &rest, DLM, false);
+            *target = atoi(tok);
+            delete[] tok;
+
+            // skip to inside of brackets
+            delete[] next_token(rest, &rest, '{', false);
+            if (head != nullptr) {
+                tok = next_token(rest, &rest, DLM, false);
+                *head = strtoull(tok, nullptr, 10);
+                delete[] tok;
+            }
+            tok = next_token(rest, &rest, DLM, false);
+            *id = strtoull(tok, nullptr, 10);
+            delete[] tok;
+            tok = next_token(rest, &rest, DLM, false);
+            *size = atoi(tok);
+            delete[] tok;
+
+            *keys = new Key*[*size];
+            if (vals != nullptr) *vals = new DataFrame*[*size];
+            for (size_t i = 0; i < *size; ++i) {
+                delete[] next_token(rest, &rest, '{', false);
+                // key and dataframe remove escapes when deserializing
+                tok = next_token(rest, &rest, vals == nullptr ? '}' : '|', false);
+                (*keys)[i] = Key::deserialize(tok);
+                delete[] tok;
+                if (vals == nullptr) continue;
+                tok = next_token(rest, &rest, '}', false);
+                (*vals)[i] = tok[0] == '\0' ? nullptr : DataFrame::deserialize(tok);
+                delete[] tok;
+            }
+        }
+};
+
+// message sent from one node to another to put in many keys at once
+class PutMany : public ManyMessage {
+    public:
+        PutMany(int sender, int target, size_t size, Key** keys, DataFrame** vals)
+            : ManyMessage(MsgKind::PutMany, sender, target, size, keys, vals, 0) { }
+
+        // deserializes the given string into a PutMany message, see ManyMessage for the format
+        static PutMany* deserialize(char* m) {
+            int sender, target;
+            size_t id, size;
+            Key** keys;
+            DataFrame** vals;
+            deserialize_many_(m, "PutMany", &sender, &target, &id, &size, &keys, &vals);
+            PutMany* out = new PutMany(sender, target, size, keys, vals);
+            delete[] keys;
+            delete[] vals;
+            return out;
+        }
+};
+
+// message sent from one node to another to get many keys at once
+// if wait is true, the keys are only sent back once all of them exist (as a WaitGetMany message)
+class GetMany : public ManyMessage {
+    public:
+        GetMany(int sender, int target, size_t size, Key** keys, bool wait, size_t id)
+            : ManyMessage(wait ? MsgKind::WaitGetMany : MsgKind::GetMany, sender, target, size,
+                    keys, nullptr, id) { }
+
+        // returns true if this message waits for its keys to exist
+        bool wait() { return kind_ == MsgKind::WaitGetMany; }
+
+        // deserializes the given string into a GetMany or WaitGetMany message, see ManyMessage for
+        // the format
+        static GetMany* deserialize(char* m, bool wait) {
+            int sender, target;
+            size_t id, size;
+            Key** keys;
+            deserialize_many_(m, wait ? "WaitGetMany" : "GetMany", &sender, &target, &id, &size,
+                    &keys, nullptr);
+            GetMany* out = new GetMany(sender, target, size, keys, wait, id);
+            delete[] keys;
+            return out;
+        }
+};
+
+// message sent from one node to another in response to a GetMany or WaitGetMany request
+// the keys are in the same order as in the request
+class GetManyReply : public ManyMessage {
+    public:
+        GetManyReply(int sender, int target, size_t size, Key** keys, DataFrame** vals, size_t id)
+            : ManyMessage(MsgKind::GetManyReply, sender, target, size, keys, vals, id) { }
+
+        // deserializes the given string into a GetManyReply message, see ManyMessage for the format
+        static GetManyReply* deserialize(char* m) {
+            int sender, target;
+            size_t id, size;
+            Key** keys;
+            DataFrame** vals;
+            deserialize_many_(m, "GetManyReply", &sender, &target, &id, &size, &keys, &vals);
+            GetManyReply* out = new GetManyReply(sender, target, size, keys, vals, id);
+            delete[] keys;
+            delete[] vals;
+            return out;
+        }
+};
+
+// message sent from one node to another to apply a MergeOp to many of its keys at once
+// the operand of each key is its value in the message, and there is no reply
+class MergeMany : public ManyMessage {
+    public:
+        MergeOp op_; // operation to apply to every key
+
+        MergeMany(int sender, int target, MergeOp op, size_t size, Key** keys, DataFrame** vals)
+            : ManyMessage(MsgKind::MergeMany, sender, target, size, keys, vals, 0) {
+            op_ = op;
+        }
+
+        // sends the operation first: MergeMany <sender_> <target_> {<op_> <id_> <size_> ...}
+        void serialize_head_(StrBuff* sb) {
+            sb->c((size_t)op_);
+            sb->c(DLM);
+        }
+
+        // deserializes the given string into a MergeMany message, see ManyMessage for the format
+        static MergeMany* deserialize(char* m) {
+            int sender, target;
+            size_t op, id, size;
+            Key** keys;
+            DataFrame** vals;
+            deserialize_many_(m, "MergeMany", &sender, &target, &id, &size, &keys, &vals, &op);
+            check(op < MERGE_OPS, "Invalid MergeMany operation");
+            MergeMany* out = new MergeMany(sender, target, (MergeOp)op, size, keys, vals);
+            delete[] keys;
+            delete[] vals;
+            return out;
+        }
+};
+
+// message sent from one node to another to remove many of its keys at once, and delete their values
+// if prefix is true, the string of each key is a prefix, and every key that starts with it is
+// removed - there is no reply
+class Remove : public ManyMessage {
+    public:
+        bool prefix_; // true if the keys are prefixes
+
+        Remove(int sender, int target, size_t size, Key** keys, bool prefix)
+            : ManyMessage(MsgKind::Remove, sender, target, size, keys, nullptr, 0) {
+            prefix_ = prefix;
+        }
+
+        // sends the prefix flag first: Remove <sender_> <target_> {<0|1> <id_> <size_> ...}
+        void serialize_head_(StrBuff* sb) {
+            sb->c(prefix_ ? "1" : "0");
+            sb->c(DLM);
+        }
+
+        // deserializes the given string into a Remove message, see ManyMessage for the format
+        static Remove* deserialize(char* m) {
+            int sender, target;
+            size_t prefix, id, size;
+            Key** keys;
+            deserialize_many_(m, "Remove", &sender, &target, &id, &size, &keys, nullptr, &prefix);
+            check(prefix <= 1, "Invalid Remove message");
+            Remove* out = new Remove(sender, target, size, keys, prefix == 1);
+            delete[] keys;
+            return out;
+        }
+};
+
+// message sent from one node to another to list one batch of the keys that start with a prefix
+// the target answers with a ScanReply with the same id holding, in order, at most max_ of its
+// keys that start with the string of prefix_ and come after the string of after_ (from its first
+// such key if after_ is nullptr), and their values if values_ is true
+class Scan : public Message {
+    public:
+        Key* prefix_; // key with the prefix as its string and the target's index
+        Key* after_; // key with the last string of the previous batch, nullptr for the first batch
+        size_t max_; // most keys to send back
+        bool values_; // true if the values are sent back too
+        size_t id_; // id of the request, sent back in the ScanReply
+
+        // the keys stay owned by the caller
+        Scan(int sender, Key* prefix, Key* after, size_t max, bool values, size_t id)
+                : Message(MsgKind::Scan, sender, prefix->idx_) {
+            prefix_ = prefix;
+            after_ = after;
+            max_ = max;
+            values_ = values;
+            id_ = id;
+        }
+
+        // serializes this scan message into the following format:
+        // Scan <sender_> <target_> {<id_> <max_> <values_> {<str> <idx>} {<str> <idx>}}
+
+        // the first batch is sent without a key in the second brackets: {}
+        char* serialize() {
+            StrBuff* sb = new StrBuff();
+            sb->c(id_);
+            sb->c(DLM);
+            sb->c(max_);
+            sb->c(DLM);
+            sb->c(values_ ? "1" : "0");
+            sb->c(" {");
+            char* tmp = prefix_->serialize();
+            sb->c(tmp);
+            delete[] tmp;
+            sb->c("} {");
+            if (after_ != nullptr) {
+                tmp = after_->serialize();
+                sb->c(tmp);
+                delete[] tmp;
+            }
+            sb->c('}');
+
+            tmp = sb->no_cpy_get();
+            char* out = wrap_with_header_(tmp);
+            delete[] tmp;
+            delete sb;
+            return out;
+        }
+
+        // deserializes the given string into a Scan message
+        // the keys of the message are owned by the caller
+        static Scan* deserialize(char* m) {
             char* rest = nullptr;
             char* tok = next_token(m, &rest, DLM, false);
-            check(streq(tok, "WaitGet"), "Invalid WaitGet message");
+            check(streq(tok, "Scan"), "Invalid Scan message");
             delete[] tok;
 
             tok = next_token(rest, &rest, DLM, false);
             int sender = atoi(tok);
             delete[] tok;
 
+            // skip to inside of brackets
             delete[] next_token(rest, &rest, '{', false);
-            tok = next_token(rest, &rest, '}', true); // key handles escapes
-            Key* k = Key::deserialize(tok);
+            tok = next_token(rest, &rest, DLM, false);
+            size_t id = strtoull(tok, nullptr, 10);
+            delete[] tok;
+            tok = next_token(rest, &rest, DLM, false);
+            size_t max = strtoull(tok, nullptr, 10);
+            delete[] tok;
+            tok = next_token(rest, &rest, DLM, false);
+            bool values = streq(tok, "1");
+            delete[] tok;
+
+            // keys remove escapes when deserializing
+            delete[] next_token(rest, &rest, '{', false);
+            tok = next_token(rest, &rest, '}', false);
+            Key* prefix = Key::deserialize(tok);
+            delete[] tok;
+            delete[] next_token(rest, &rest, '{', false);
+            tok = next_token(rest, &rest, '}', false);
+            Key* after = tok[0] == '\0' ? nullptr : Key::deserialize(tok);
             delete[] tok;
 
-            return new WaitGet(sender, k);
+            return new Scan(sender, prefix, after, max, values, id);
         }
 };
 
-// message sent from one node to another in response to a get request
-class GetReply : public Message {
+// message sent from one node to another in response to a Scan request, with the keys in order
+// the values are always sent (nullptr if the request did not ask for them), and a batch of less
+// than the max_ of the request is the last one
+class ScanReply : public ManyMessage {
     public:
-        Key* key_; // key from the get request
-        DataFrame* df_; // corresponding dataframe
-        
-        // creates a GetReply message with the given target, key, and dataframe
-        GetReply(int target, Key* key, DataFrame* df) : Message(MsgKind::GetReply, key->idx_, target) {
+        ScanReply(int sender, int target, size_t size, Key** keys, DataFrame** vals, size_t id)
+            : ManyMessage(MsgKind::ScanReply, sender, target, size, keys, vals, id) { }
+
+        // deserializes the given string into a ScanReply message, see ManyMessage for the format
+        static ScanReply* deserialize(char* m) {
+            int sender, target;
+            size_t id, size;
+            Key** keys;
+            DataFrame** vals;
+            deserialize_many_(m, "ScanReply", &sender, &target, &id, &size, &keys, &vals);
+            ScanReply* out = new ScanReply(sender, target, size, keys, vals, id);
+            delete[] keys;
+            delete[] vals;
+            return out;
+        }
+};
+
+// message sent from one node to another during a collective (gather, reduce or allreduce)
+// each key is named after the collective and indexed by the node its value came from, and the
+// values go to the collective inbox of the target instead of its store
+class Collect : public ManyMessage {
+    public:
+        Collect(int sender, int target, size_t size, Key** keys, DataFrame** vals)
+            : ManyMessage(MsgKind::Collect, sender, target, size, keys, vals, 0) { }
+
+        // deserializes the given string into a Collect message, see ManyMessage for the format
+        static Collect* deserialize(char* m) {
+            int sender, target;
+            size_t id, size;
+            Key** keys;
+            DataFrame** vals;
+            deserialize_many_(m, "Collect", &sender, &target, &id, &size, &keys, &vals);
+            Collect* out = new Collect(sender, target, size, keys, vals);
+            delete[] keys;
+            delete[] vals;
+            return out;
+        }
+};
+
+// message that carries a value from the root of a broadcast down a tree of nodes
+// the key and value are serialized once, by the root, and every node that forwards the message
+// sends the same serialized body on without deserializing and serializing it again
+class Broadcast : public Message {
+    public:
+        int root_; // index of the node the broadcast started from
+        char* body_; // owned, the serialized key and value: <str> <idx>|<col_types> <nrows> [...]
+
+        // serializes the given key and value (both stay owned by the caller)
+        // the target is set with update_target before each send
+        Broadcast(int sender, Key* key, DataFrame* val) : Message(MsgKind::Broadcast, sender, SIDX) {
+            root_ = sender;
+            StrBuff sb;
+            char* tmp = key->serialize();
+            sb.c(tmp);
+            delete[] tmp;
+            sb.c('|');
+            tmp = val->serialize();
+            sb.c(tmp);
+            delete[] tmp;
+            body_ = sb.get();
+        }
+
+        // takes ownership of the given serialized body
+        Broadcast(int sender, int target, int root, char* body)
+            : Message(MsgKind::Broadcast, sender, target) {
+            root_ = root;
+            body_ = body;
+        }
+
+        ~Broadcast() {
+            delete[] body_;
+        }
+
+        // returns the key of the value (owned by the caller), its index is the root's
+        Key* key() {
+            char* rest = nullptr;
+            char* tok = next_token(body_, &rest, '|', false);
+            Key* out = Key::deserialize(tok);
+            delete[] tok;
+            return out;
+        }
+
+        // returns the value (owned by the caller)
+        DataFrame* value() {
+            return DataFrame::deserialize(body_ + index_of(body_, '|', true) + 1);
+        }
+
+        // serializes this message into the following format:
+        // Broadcast <sender_> <target_> {<root_> <body_>}\n
+        char* serialize() {
+            StrBuff* sb = new StrBuff();
+            sb->c((size_t)root_);
+            sb->c(DLM);
+            sb->c(body_);
+            char* tmp = sb->no_cpy_get();
+            char* out = wrap_with_header_(tmp);
+            delete[] tmp;
+            delete sb;
+            return out;
+        }
+
+        // deserializes the given string into a Broadcast message
+        static Broadcast* deserialize(char* m) {
+            char* rest = nullptr;
+            char* tok = next_token(m, &rest, DLM, false);
+            check(streq(tok, "Broadcast"), "Invalid Broadcast message");
+            delete[] tok;
+
+            tok = next_token(rest, &rest, DLM, false);
+            int sender = atoi(tok);
+            delete[] tok;
+            tok = next_token(rest, &rest, DLM, false);
+            int target = atoi(tok);
+            delete[] tok;
+
+            // skip to inside of brackets
+            delete[] next_token(rest, &rest, '{', false);
+            tok = next_token(rest, &rest, DLM, false);
+            int root = atoi(tok);
+            delete[] tok;
+            // the body keeps its escapes, it is sent on as it is
+            char* body = next_token(rest, &rest, '}', false);
+            return new Broadcast(sender, target, root, body);
+        }
+};
+
+// message sent from one node to another in one round of a barrier
+// carries no data, only which barrier (counted from 0 by every node) and which round it is for
+class Barrier : public Message {
+    public:
+        size_t epoch_; // number of barriers the sender passed before this one
+        size_t round_; // round of the barrier
+
+        Barrier(int sender, int target, size_t epoch, size_t round)
+            : Message(MsgKind::Barrier, sender, target) {
+            epoch_ = epoch;
+            round_ = round;
+        }
+
+        // serializes this barrier message into the following format:
+        // Barrier <sender_> <target_> {<epoch_> <round_>}\n
+        char* serialize() {
+            StrBuff* sb = new StrBuff();
+            sb->c(epoch_);
+            sb->c(DLM);
+            sb->c(round_);
+            char* tmp = sb->no_cpy_get();
+            char* out = wrap_with_header_(tmp);
+            delete[] tmp;
+            delete sb;
+            return out;
+        }
+
+        // deserializes the given string into a barrier message
+        static Barrier* deserialize(char* m) {
+            char* rest = nullptr;
+            char* tok = next_token(m, &rest, DLM, false);
+            check(streq(tok, "Barrier"), "Invalid Barrier message");
+            delete[] tok;
+
+            tok = next_token(rest, &rest, DLM, false);
+            int sender = atoi(tok);
+            delete[] tok;
+            tok = next_token(rest, &rest, DLM, false);
+            int target = atoi(tok);
+            delete[] tok;
+
+            // skip to inside of brackets
+            delete[] next_token(rest, &rest, '{', false);
+            tok = next_token(rest, &rest, DLM, false);
+            size_t epoch = strtoull(tok, nullptr, 10);
+            delete[] tok;
+            tok = next_token(rest, &rest, '}', false);
+            size_t round = strtoull(tok, nullptr, 10);
+            delete[] tok;
+            check(round < BARRIER_ROUNDS, "Invalid Barrier round");
+            return new Barrier(sender, target, epoch, round);
+        }
+};
+
+// message sent from one node to another to run a registered RemoteRower over the value of one
+// of its keys, the owner answers with the rower's result in a GetReply with the same id
+class Execute : public Message {
+    public:
+        Key* key_; // key of the value to run over
+        char* name_; // owned, name the type of the rower is registered under
+        DataFrame* state_; // state the rower is made from
+        size_t id_; // id of the request, sent back in the GetReply
+
+        // copies the given name, the key and state stay owned by the caller
+        Execute(int sender, Key* key, const char* name, DataFrame* state, size_t id)
+                : Message(MsgKind::Execute, sender, key->idx_) {
             key_ = key;
-            df_ = df;
+            name_ = duplicate(name);
+            state_ = state;
+            id_ = id;
         }
 
-        // serializes this GetReply message into the following format:
-        // GetReply <sender_> <target_> {<str> <idx>|<col_types> <nrows> [...]}\n
+        ~Execute() {
+            delete[] name_;
+        }
+
+        // serializes this execute message into the following format:
+        // Execute <sender_> <target_> {<id_> <name_> <str> <idx>|<col_types> <nrows> [...]}\n
         char* serialize() {
             StrBuff* sb = new StrBuff();
+            sb->c(id_);
+            sb->c(DLM);
+            sb->c(name_);
+            sb->c(DLM);
             char* tmp = key_->serialize();
             sb->c(tmp);
             delete[] tmp;
 
             sb->c('|');
-            tmp = df_->serialize();
+            tmp = state_->serialize();
             sb->c(tmp);
             delete[] tmp;
 
             tmp = sb->no_cpy_get();
-            char* out = wrap_with_header_(tmp); // don't want to use get(), extra dup
+            char* out = wrap_with_header_(tmp);
             delete[] tmp;
             delete sb;
             return out;
         }
 
-        static GetReply* deserialize(char* m) {
+        // deserializes the given string into an Execute message
+        // the key and state of the message are owned by the caller
+        static Execute* deserialize(char* m) {
             char* rest = nullptr;
             char* tok = next_token(m, &rest, DLM, false);
-            check(streq(tok, "GetReply"), "Invalid GetReply message");
+            check(streq(tok, "Execute"), "Invalid Execute message");
             delete[] tok;
 
-            // skip the sender
-            delete[] next_token(rest, &rest, DLM, false);
-
             tok = next_token(rest, &rest, DLM, false);
-            int target = atoi(tok);
+            int sender = atoi(tok);
             delete[] tok;
 
             // skip to inside of brackets
             delete[] next_token(rest, &rest, '{', false);
+            tok = next_token(rest, &rest, DLM, false);
+            size_t id = strtoull(tok, nullptr, 10);
+            delete[] tok;
+            char* name = next_token(rest, &rest, DLM, false);
             tok = next_token(rest, &rest, '|', false); // key removes escapes when deserializing
             Key* k = Key::deserialize(tok);
             delete[] tok;
 
             tok = next_token(rest, &rest, '}', false); // dataframe removes escapes
-            DataFrame* d = DataFrame::deserialize(tok);
+            DataFrame* state = DataFrame::deserialize(tok);
             delete[] tok;
 
-            return new GetReply(target, k, d);
+            Execute* out = new Execute(sender, k, name, state, id);
+            delete[] name;
+            return out;
         }
 };
 
-
 // message sent by a node to another node
 // can be used to wrap another serializable class
 // ex. pass serialized Class to Text constructor to serialize
@@ -633,6 +1297,33 @@ class Kill : public Message {
         }
 };
 
+// message sent from a node to the server once the node will not send any more messages to other
+// nodes, the server only sends Kill messages once every node has sent one
+class Done : public Message {
+    public:
+        Done(int sender) : Message(MsgKind::Done, sender, SIDX) {}
+
+        // serializes a done message in the following format:
+        // "Done <sender_> <SIDX> {}\n"
+        char* serialize() {
+            return wrap_with_header_(const_cast<char*>(""));
+        }
+
+        // deserializes a string into a done message
+        static Done* deserialize(char* m) {
+            char* rest = nullptr;
+            char* tok = next_token(m, &rest, DLM, false);
+            check(streq(tok, "Done"), "Invalid Done message");
+            delete[] tok;
+
+            tok = next_token(rest, &rest, DLM, false);
+            int sender = atoi(tok);
+            delete[] tok;
+
+            return new Done(sender);
+        }
+};
+
 
 // deserializes the given character sequence into the correct message
 Message* Message::deserialize(char* m) {
@@ -653,6 +1344,19 @@ Message* Message::deserialize(char* m) {
     else if (streq(kind, "GetReply")) out = GetReply::deserialize(m);
     else if (streq(kind, "Text")) out = Text::deserialize(m);
     else if (streq(kind, "Kill")) out = Kill::deserialize(m);
+    else if (streq(kind, "Done")) out = Done::deserialize(m);
+    else if (streq(kind, "PutMany")) out = PutMany::deserialize(m);
+    else if (streq(kind, "GetMany")) out = GetMany::deserialize(m, false);
+    else if (streq(kind, "WaitGetMany")) out = GetMany::deserialize(m, true);
+    else if (streq(kind, "GetManyReply")) out = GetManyReply::deserialize(m);
+    else if (streq(kind, "MergeMany")) out = MergeMany::deserialize(m);
+    else if (streq(kind, "Broadcast")) out = Broadcast::deserialize(m);
+    else if (streq(kind, "Collect")) out = Collect::deserialize(m);
+    else if (streq(kind, "Barrier")) out = Barrier::deserialize(m);
+    else if (streq(kind, "Execute")) out = Execute::deserialize(m);
+    else if (streq(kind, "Remove")) out = Remove::deserialize(m);
+    else if (streq(kind, "Scan")) out = Scan::deserialize(m);
+    else if (streq(kind, "ScanReply")) out = ScanReply::deserialize(m);
     else check(false, "Invalid Message kind");
 
     delete[] kind;
@@ -174,13 +174,13 @@ void testPut() {
 
 // tests serialization and deserializatoin of Get message
 void testGet() {
-    Key* k = new Key("Key1", 1);
+    Key* k = new Key("Key 1", 1);
     int sender = 1;
-    Get* g = new Get(sender, k);
+    Get* g = new Get(sender, k, 7);
 
     char* gs = g->serialize();
     printf("%s", gs);
-    check(streq(gs, "Get 1 1 {Key1 1}\n"), "Get serialization failed");
+    check(streq(gs, "Get 1 1 {7 Key\\ 1 1}\n"), "Get serialization failed");
 
     Get* gd = dynamic_cast<Get*>(Message::deserialize(gs));
     check(gd != nullptr, "Cast failed");
@@ -188,6 +188,7 @@ void testGet() {
     check(g->get_sender() == gd->get_sender(), "Incorrect sender");
     check(g->get_target() == gd->get_target(), "Incorrect target");
     check(g->key_->equals(gd->key_), "Mismatched keys");
+    check(gd->id_ == 7, "Mismatched ids");
 
     delete k;
     delete g;
@@ -202,11 +203,11 @@ void testGet() {
 void testWaitGet() {
     Key* k = new Key("Key1", 1);
     int sender = 1;
-    WaitGet* wg = new WaitGet(sender, k);
+    WaitGet* wg = new WaitGet(sender, k, 42);
 
     char* wgs = wg->serialize();
     printf("%s", wgs);
-    check(streq(wgs, "WaitGet 1 1 {Key1 1}\n"), "Wait Get serialization failed");
+    check(streq(wgs, "WaitGet 1 1 {42 Key1 1}\n"), "Wait Get serialization failed");
 
     WaitGet* wgd = dynamic_cast<WaitGet*>(Message::deserialize(wgs));
     check(wgd != nullptr, "Cast failed");
@@ -214,6 +215,7 @@ void testWaitGet() {
     check(wg->get_sender() == wgd->get_sender(), "Incorrect sender");
     check(wg->get_target() == wgd->get_target(), "Incorrect target");
     check(wg->key_->equals(wgd->key_), "Mismatched keys");
+    check(wgd->id_ == 42, "Mismatched ids");
 
     delete k;
     delete wg;
@@ -242,10 +244,10 @@ void testGetReply() {
     df->set(1, 1, -15);
     df->set(1, 2, 256);
 
-    GetReply* r = new GetReply(1, k, df);
+    GetReply* r = new GetReply(1, k, df, 3);
     char* rs = r->serialize();
     printf("%s", rs);
-    check(streq(rs, "GetReply 2 1 {wier\\|\\]d\\ \\}chars\\\\\\\n 2|BI 3 [[1 0 1] [12 -15 256]]}\n"),
+    check(streq(rs, "GetReply 2 1 {3 wier\\|\\]d\\ \\}chars\\\\\\\n 2|BI 3 [[1 0 1] [12 -15 256]]}\n"),
             "Incorrect GetReply serialization");
 
     GetReply* rd = GetReply::deserialize(rs);
@@ -255,6 +257,17 @@ void testGetReply() {
     check(rd->key_->equals(r->key_), "Incorrect key");
     check(rd->df_->get_bool(0, 2) == 1, "Mismatched data");
     check(rd->df_->get_int(1, 1) == -15, "Mismatched data");
+    check(rd->id_ == 3, "Mismatched ids");
+
+    // a key that does not exist is answered without a dataframe
+    GetReply* none = new GetReply(1, k, nullptr, 4);
+    char* ns = none->serialize();
+    GetReply* nd = GetReply::deserialize(ns);
+    check(nd->df_ == nullptr && nd->id_ == 4 && nd->key_->equals(k), "Incorrect empty GetReply");
+    delete none;
+    delete[] ns;
+    delete nd->key_;
+    delete nd;
 
     delete k;
     delete s;
@@ -315,6 +328,286 @@ void testKill() {
     puts("Test Kill passed");
 }
 
+// tests serialization and deserialization of Done message
+void testDone() {
+    Done* d = new Done(2);
+
+    char* ds = d->serialize();
+    printf("%s", ds);
+    check(streq(ds, "Done 2 -1 {}\n"), "Done serialization failed");
+
+    Done* dd = dynamic_cast<Done*>(Message::deserialize(ds));
+    check(dd != nullptr, "Cast failed");
+    check(dd->sender_ == 2 && dd->target_ == SIDX, "Mismatched nodes");
+
+    delete d;
+    delete[] ds;
+    delete dd;
+
+    puts("Test Done passed");
+}
+
+
+// tests serialization and deserialization of the batched messages
+void testMany() {
+    Key* keys[3] = {new Key("a b", 2), new Key("wier|]d }chars", 2), new Key("c", 2)};
+    Schema* s = new Schema("I");
+    s->add_row();
+    DataFrame* df = new DataFrame(*s);
+    df->set(0, 0, 7);
+    DataFrame* vals[3] = {df, nullptr, df};
+
+    PutMany* p = new PutMany(1, 2, 3, keys, vals);
+    char* ps = p->serialize();
+    printf("%s", ps);
+    check(streq(ps, "PutMany 1 2 {0 3 {a\\ b 2|I 1 [[7]]} {wier\\|\\]d\\ \\}chars 2|} {c 2|I 1 [[7]]}}\n"),
+            "Incorrect PutMany serialization");
+    PutMany* pd = dynamic_cast<PutMany*>(Message::deserialize(ps));
+    check(pd != nullptr && pd->kind_ == MsgKind::PutMany, "Kind not PutMany");
+    check(pd->sender_ == 1 && pd->target_ == 2 && pd->size_ == 3, "Incorrect header");
+    for (size_t i = 0; i < 3; ++i) check(pd->keys_[i]->equals(keys[i]), "Incorrect key");
+    check(pd->vals_[0]->get_int(0, 0) == 7 && pd->vals_[1] == nullptr, "Mismatched data");
+
+    GetMany* g = new GetMany(1, 2, 3, keys, true, 5);
+    char* gs = g->serialize();
+    printf("%s", gs);
+    check(streq(gs, "WaitGetMany 1 2 {5 3 {a\\ b 2} {wier\\|\\]d\\ \\}chars 2} {c 2}}\n"),
+            "Incorrect WaitGetMany serialization");
+    GetMany* gd = dynamic_cast<GetMany*>(Message::deserialize(gs));
+    check(gd != nullptr && gd->wait() && gd->vals_ == nullptr && gd->id_ == 5, "Kind not WaitGetMany");
+    for (size_t i = 0; i < 3; ++i) check(gd->keys_[i]->equals(keys[i]), "Incorrect key");
+
+    GetManyReply* r = new GetManyReply(2, 1, 3, keys, vals, 5);
+    char* rs = r->serialize();
+    GetManyReply* rd = dynamic_cast<GetManyReply*>(Message::deserialize(rs));
+    check(rd != nullptr && rd->sender_ == 2 && rd->target_ == 1 && rd->id_ == 5,
+            "Incorrect GetManyReply");
+    check(rd->vals_[2]->get_int(0, 0) == 7 && rd->vals_[1] == nullptr, "Mismatched data");
+
+    MergeMany* mm = new MergeMany(1, 2, MergeOp::Or, 3, keys, vals);
+    char* ms = mm->serialize();
+    check(strncmp(ms, "MergeMany 1 2 {2 0 3 {", 22) == 0, "Incorrect MergeMany serialization");
+    MergeMany* md = dynamic_cast<MergeMany*>(Message::deserialize(ms));
+    check(md != nullptr && md->op_ == MergeOp::Or && md->size_ == 3, "Incorrect MergeMany");
+    check(md->vals_[0]->get_int(0, 0) == 7 && md->keys_[1]->equals(keys[1]), "Mismatched data");
+
+    Collect* c = new Collect(1, 2, 3, keys, vals);
+    char* cs = c->serialize();
+    check(strncmp(cs, "Collect 1 2 {0 3 {", 18) == 0, "Incorrect Collect serialization");
+    Collect* cd = dynamic_cast<Collect*>(Message::deserialize(cs));
+    check(cd != nullptr && cd->size_ == 3 && cd->vals_[1] == nullptr, "Incorrect Collect");
+    check(cd->vals_[2]->get_int(0, 0) == 7 && cd->keys_[1]->equals(keys[1]), "Mismatched data");
+
+    for (size_t i = 0; i < 3; ++i) delete keys[i];
+    delete s;
+    delete df;
+    delete mm;
+    delete[] ms;
+    md->delete_data();
+    delete md;
+    delete c;
+    delete[] cs;
+    cd->delete_data();
+    delete cd;
+    delete p;
+    delete[] ps;
+    pd->delete_data();
+    delete pd;
+    delete g;
+    delete[] gs;
+    gd->delete_data();
+    delete gd;
+    delete r;
+    delete[] rs;
+    rd->delete_data();
+    delete rd;
+
+    puts("Test Many passed");
+}
+
+// tests serialization and deserialization of Broadcast message, and forwarding its body as is
+void testBroadcast() {
+    Key* k = new Key("nu|}-1", 0);
+    Schema* s = new Schema("IS");
+    s->add_row();
+    DataFrame* df = new DataFrame(*s);
+    df->set(0, 0, 3);
+    String* str = new String("a}b");
+    df->set(1, 0, str);
+
+    Broadcast* b = new Broadcast(0, k, df);
+    b->update_target(2);
+    char* bs = b->serialize();
+    printf("%s", bs);
+    check(streq(bs, "Broadcast 0 2 {0 nu\\|\\}-1 0|IS 1 [[3] [a\\}b]]}\n"),
+            "Incorrect Broadcast serialization");
+    Broadcast* bd = dynamic_cast<Broadcast*>(Message::deserialize(bs));
+    check(bd != nullptr && bd->root_ == 0 && bd->target_ == 2, "Incorrect Broadcast");
+    check(streq(bd->body_, b->body_), "Mismatched body");
+
+    // a forwarded copy is the same message with a new sender and target
+    bd->sender_ = 2;
+    bd->update_target(3);
+    char* fs = bd->serialize();
+    Broadcast* fd = dynamic_cast<Broadcast*>(Message::deserialize(fs));
+    check(fd->sender_ == 2 && fd->target_ == 3 && fd->root_ == 0, "Incorrect forwarded Broadcast");
+    Key* fk = fd->key();
+    DataFrame* fv = fd->value();
+    check(fk->equals(k), "Mismatched key");
+    check(fv->get_int(0, 0) == 3 && fv->get_string(1, 0)->equals(str), "Mismatched data");
+
+    delete k;
+    delete s;
+    delete df; // owns str
+    delete b;
+    delete[] bs;
+    delete bd;
+    delete[] fs;
+    delete fd;
+    delete fk;
+    delete fv;
+
+    puts("Test Broadcast passed");
+}
+
+// tests serialization and deserialization of Barrier message
+void testBarrier() {
+    Barrier* b = new Barrier(3, 4, 12, 2);
+    char* bs = b->serialize();
+    printf("%s", bs);
+    check(streq(bs, "Barrier 3 4 {12 2}\n"), "Barrier serialization failed");
+    Barrier* bd = dynamic_cast<Barrier*>(Message::deserialize(bs));
+    check(bd != nullptr && bd->kind_ == MsgKind::Barrier, "Cast failed");
+    check(bd->sender_ == 3 && bd->target_ == 4, "Incorrect header");
+    check(bd->epoch_ == 12 && bd->round_ == 2, "Incorrect epoch or round");
+
+    delete b;
+    delete[] bs;
+    delete bd;
+
+    puts("Test Barrier passed");
+}
+
+// tests serialization and deserialization of Execute message
+void testExecute() {
+    Key* k = new Key("ct_1", 3);
+    DataFrame* state = DataFrame::from_scalar(2);
+    Execute* e = new Execute(1, k, "sum", state, 7);
+    char* es = e->serialize();
+    printf("%s", es);
+    check(streq(es, "Execute 1 3 {7 sum ct_1 3|I 1 [[2]]}\n"), "Execute serialization failed");
+    Execute* ed = dynamic_cast<Execute*>(Message::deserialize(es));
+    check(ed != nullptr && ed->sender_ == 1 && ed->target_ == 3 && ed->id_ == 7, "Incorrect header");
+    check(streq(ed->name_, "sum") && ed->key_->equals(k), "Incorrect name or key");
+    check(ed->state_->get_int(0, 0) == 2, "Incorrect state");
+
+    delete k;
+    delete state;
+    delete e;
+    delete[] es;
+    delete ed->key_;
+    delete ed->state_;
+    delete ed;
+
+    puts("Test Execute passed");
+}
+
+// tests serialization and deserialization of Remove message, with keys and with prefixes
+void testRemove() {
+    Key* keys[2] = {new Key("nu-1", 2), new Key("np-1", 2)};
+    Remove* r = new Remove(0, 2, 2, keys, false);
+    char* rs = r->serialize();
+    printf("%s", rs);
+    check(streq(rs, "Remove 0 2 {0 0 2 {nu-1 2} {np-1 2}}\n"), "Remove serialization failed");
+    Remove* rd = dynamic_cast<Remove*>(Message::deserialize(rs));
+    check(rd != nullptr && ! rd->prefix_ && rd->size_ == 2, "Incorrect Remove");
+    check(rd->keys_[1]->equals(keys[1]), "Mismatched key");
+
+    Remove* p = new Remove(0, 2, 1, keys, true);
+    char* ps = p->serialize();
+    check(streq(ps, "Remove 0 2 {1 0 1 {nu-1 2}}\n"), "Prefix Remove serialization failed");
+    Remove* pd = dynamic_cast<Remove*>(Message::deserialize(ps));
+    check(pd->prefix_ && pd->size_ == 1 && pd->keys_[0]->equals(keys[0]), "Incorrect prefix Remove");
+
+    delete keys[0];
+    delete keys[1];
+    delete r;
+    delete[] rs;
+    rd->delete_data();
+    delete rd;
+    delete p;
+    delete[] ps;
+    pd->delete_data();
+    delete pd;
+
+    puts("Test Remove passed");
+}
+
+void testScan() {
+    Key* prefix = new Key("ct_", 1);
+    Key* after = new Key("ct_ 9", 1); // strings are escaped
+    Scan* sc = new Scan(0, prefix, after, 64, true, 7);
+    char* ss = sc->serialize();
+    printf("%s", ss);
+    check(streq(ss, "Scan 0 1 {7 64 1 {ct_ 1} {ct_\\ 9 1}}\n"), "Scan serialization failed");
+    Scan* sd = dynamic_cast<Scan*>(Message::deserialize(ss));
+    check(sd != nullptr && sd->sender_ == 0 && sd->target_ == 1 && sd->id_ == 7, "Incorrect Scan");
+    check(sd->max_ == 64 && sd->values_ && sd->prefix_->equals(prefix), "Incorrect Scan");
+    check(sd->after_ != nullptr && sd->after_->equals(after), "Incorrect Scan cursor");
+
+    // the first batch has no cursor, and an empty prefix lists every key
+    Key* all = new Key("", 1);
+    Scan* first = new Scan(0, all, nullptr, 8, false, 8);
+    char* fs = first->serialize();
+    Scan* fd = dynamic_cast<Scan*>(Message::deserialize(fs));
+    check(fd->after_ == nullptr && ! fd->values_ && streq(fd->prefix_->str_, ""), "Incorrect Scan");
+
+    Key* keys[2] = {new Key("ct_1", 1), new Key("ct_2", 1)};
+    DataFrame* vals[2] = {DataFrame::from_scalar(4), nullptr};
+    ScanReply* r = new ScanReply(1, 0, 2, keys, vals, 7);
+    char* rs = r->serialize();
+    ScanReply* rd = dynamic_cast<ScanReply*>(Message::deserialize(rs));
+    check(rd != nullptr && rd->id_ == 7 && rd->size_ == 2, "Incorrect ScanReply");
+    check(rd->keys_[1]->equals(keys[1]) && rd->vals_[0]->get_int(0, 0) == 4, "Incorrect ScanReply");
+    check(rd->vals_[1] == nullptr, "Incorrect ScanReply");
+
+    delete prefix;
+    delete after;
+    delete sc;
+    delete[] ss;
+    delete sd->prefix_;
+    delete sd->after_;
+    delete sd;
+    delete all;
+    delete first;
+    delete[] fs;
+    delete fd->prefix_;
+    delete fd;
+    delete keys[0];
+    delete keys[1];
+    delete vals[0];
+    delete r;
+    delete[] rs;
+    rd->delete_data();
+    delete rd;
+
+    puts("Test Scan passed");
+}
+
+// an empty batch can be made from nullptr arrays (ex. the data of empty vectors)
+void testEmptyMany() {
+    GetManyReply* r = new GetManyReply(1, 0, 0, nullptr, nullptr, 3);
+    char* rs = r->serialize();
+    check(streq(rs, "GetManyReply 1 0 {3 0}\n"), "Empty GetManyReply serialization failed");
+    GetManyReply* rd = dynamic_cast<GetManyReply*>(Message::deserialize(rs));
+    check(rd != nullptr && rd->size_ == 0 && rd->id_ == 3, "Incorrect empty GetManyReply");
+
+    delete r;
+    delete[] rs;
+    delete rd;
+
+    puts("Test Empty Many passed");
+}
 
 int main() {
     testReg();
@@ -328,6 +621,14 @@ int main() {
     testGetReply();
     testText();
     testKill();
+    testDone();
+    testMany();
+    testBroadcast();
+    testBarrier();
+    testExecute();
+    testRemove();
+    testScan();
+    testEmptyMany();
     
     puts("All tests passed");
 
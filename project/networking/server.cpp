@@ -77,6 +77,28 @@ class Server : public Object {
             }
         }
 
+        // waits for a node to initiate teardown and for every node to be done sending messages to
+        // the others, and returns the Kill message of the node that initiated it
+        // without the Done messages, a node could be torn down while messages it still has to
+        // read (ex. the last ones of a collective) or send are on their way
+        Kill* wait_for_teardown_() {
+            Kill* out = nullptr;
+            size_t done = 0;
+            while (out == nullptr || done < num_nodes_) {
+                int active_idx = select_active(num_nodes_, nodes_);
+                Message* m = nodes_[active_idx]->read_msg();
+                if (m->kind_ == MsgKind::Done) {
+                    ++done;
+                    delete m;
+                } else {
+                    check(m->kind_ == MsgKind::Kill, "Server: Invalid kill message");
+                    if (out == nullptr) out = static_cast<Kill*>(m);
+                    else delete m; // teardown was already initiated
+                }
+            }
+            return out;
+        }
+
         // runs the server
         void start() {
             // accept connections from all the nodes
@@ -96,10 +118,7 @@ class Server : public Object {
             nodes_[0]->send_msg(con);
             delete con;
 
-            // wait for a node to initiate teardown
-            int active_idx = select_active(num_nodes_, nodes_); // receive Kill
-            Kill* k = dynamic_cast<Kill*>(nodes_[active_idx]->read_msg());
-            check(k != nullptr, "Server: Invalid kill message");
+            Kill* k = wait_for_teardown_();
             k->sender_ = SIDX;
             broadcast_(k); // broadcast kill message
             puts("Server: waiting for nodes to close");
@@ -2,12 +2,416 @@
 #include "../node.h"
 #include "../../data/kv_store/kv_store.h"
 #include "../../data/kv_store/kvs_impl.h"
+#include "../../data/kv_store/distributed.h"
+#include "../../data/kv_store/scan.h"
+
+// checks the collectives, every node takes part with its own index as its value
+void test_collectives(KVStore* kvs) {
+    int idx = kvs->idx_;
+    int n = kvs->node_->num_nodes_;
+    DataFrame* v = DataFrame::from_scalar(idx);
+
+    DataFrame* sum = kvs->allreduce("sum", MergeOp::Add, v);
+    check(sum->get_int(0, 0) == n * (n - 1) / 2, "Incorrect allreduce");
+
+    DataFrame* max = kvs->reduce("max", MergeOp::Max, v, 1 % n);
+    if (idx == 1 % n) check(max != nullptr && max->get_int(0, 0) == n - 1, "Incorrect reduce");
+    else check(max == nullptr, "Reduce result on a node that is not the root");
+
+    DataFrame** all = kvs->gather("all", v, n - 1);
+    if (idx == n - 1) {
+        for (int i = 0; i < n; ++i) {
+            check(all[i]->get_int(0, 0) == i, "Incorrect gather");
+            delete all[i];
+        }
+        delete[] all;
+    } else check(all == nullptr, "Gather result on a node that is not the root");
+
+    // the union of {i, i + 1} over all the nodes is {0, ..., n}
+    int e[2] = {idx, idx + 1};
+    DataFrame* pair = DataFrame::from_array(2, e);
+    DataFrame* u = kvs->allreduce("union", MergeOp::Union, pair);
+    check(u->nrows() == (size_t)n + 1, "Incorrect union");
+
+    printf("Node %d: collectives passed\n", idx);
+    delete v;
+    delete sum;
+    delete max;
+    delete pair;
+    delete u;
+}
+
+// checks that no node passes a barrier before every node has reached it
+// each node counts up a counter on node 0 before each barrier and checks it after each one
+void test_barrier(KVStore* kvs) {
+    int n = kvs->node_->num_nodes_;
+    Key* k = new Key("arrived", 0);
+    for (int i = 1; i <= 3; ++i) {
+        kvs->increment(k, 1);
+        // the get is sent on the same connection as the increment, so it sees the increment
+        DataFrame* count = kvs->get(k);
+        if (kvs->idx_ != 0) delete count; // non-local
+        kvs->barrier();
+        count = kvs->get(k);
+        check(count->get_int(0, 0) >= i * n, "Node passed barrier early");
+        if (kvs->idx_ != 0) delete count; // non-local
+    }
+    delete k;
+    printf("Node %d: barrier passed\n", kvs->idx_);
+}
+
+// adds up the ints of one column, the column is its state and the sum its result
+class SumRower : public RemoteRower {
+    public:
+        size_t col_;
+        int sum_ = 0;
+
+        SumRower(size_t col) : RemoteRower() { col_ = col; }
+
+        static RemoteRower* make(DataFrame* state) { return new SumRower(state->get_int(0, 0)); }
+
+        bool accept(Row& r) {
+            sum_ += r.get_int(col_);
+            return true;
+        }
+
+        const char* name() { return "sum"; }
+
+        DataFrame* state() { return DataFrame::from_scalar((int)col_); }
+
+        DataFrame* result() { return DataFrame::from_scalar(sum_); }
+};
+
+KVStore* running_kvs = nullptr; // store of this node, for the rowers it runs
+
+// waits until the node that asked for it puts the key gate-<that node> on the node it runs on,
+// its state is the index of the node that asked for it
+class GateRower : public RemoteRower {
+    public:
+        int from_;
+        bool opened_ = false;
+
+        GateRower(int from) : RemoteRower() { from_ = from; }
+
+        static RemoteRower* make(DataFrame* state) { return new GateRower(state->get_int(0, 0)); }
+
+        bool accept(Row& r) {
+            if (opened_) return true;
+            Key* k = Key::make_key("gate-", from_, running_kvs->idx_);
+            running_kvs->wait_and_get(k);
+            delete k;
+            opened_ = true;
+            return true;
+        }
+
+        const char* name() { return "gate"; }
+
+        DataFrame* state() { return DataFrame::from_scalar(from_); }
+
+        DataFrame* result() { return DataFrame::from_scalar(opened_); }
+};
+
+// checks running a rower on the node of every key: node i stores the ints 0, ..., 10 * i, and
+// every node adds them up where they are, for every node at once
+// a rower that waits for a put does not hold up the owner's listener, which handles the put
+void test_execute(KVStore* kvs) {
+    int idx = kvs->idx_;
+    int n = kvs->node_->num_nodes_;
+    int* vals = new int[10 * idx + 1];
+    for (int i = 0; i <= 10 * idx; ++i) vals[i] = i;
+    kvs->put(new Key("ints", idx), DataFrame::from_array(10 * idx + 1, vals)); // stored locally
+    delete[] vals;
+    kvs->barrier(); // every node has its ints
+
+    SumRower sr(0);
+    Future** futures = new Future*[n];
+    for (int i = 0; i < n; ++i) {
+        Key* k = new Key("ints", i);
+        futures[i] = kvs->execute_async(k, sr);
+        delete k;
+    }
+    for (int i = 0; i < n; ++i) {
+        DataFrame* sum = futures[i]->get();
+        check(sum->get_int(0, 0) == 10 * i * (10 * i + 1) / 2, "Incorrect remote execute");
+        delete sum;
+        delete futures[i];
+    }
+    delete[] futures;
+    Key* missing = new Key("none", (idx + 1) % n);
+    check(kvs->execute(missing, sr) == nullptr, "Remote execute of a missing key");
+    delete missing;
+
+    if (n > 1) {
+        GateRower gr(idx);
+        Key* ints = new Key("ints", (idx + 1) % n);
+        Future* f = kvs->execute_async(ints, gr);
+        Key* gate = Key::make_key("gate-", idx, (idx + 1) % n);
+        DataFrame* v = DataFrame::from_scalar(idx);
+        kvs->put(gate, v); // sent to the node that runs the rower
+        DataFrame* opened = f->get();
+        check(opened->get_bool(0, 0), "Incorrect remote execute");
+        delete opened;
+        delete f;
+        delete ints;
+        delete gate;
+        delete v;
+    }
+    printf("Node %d: execute passed\n", idx);
+}
+
+// checks keys placed by the hash ring: every node puts a few placed keys, then gets the keys of
+// every node, which all nodes place on the same nodes
+void test_placement(KVStore* kvs) {
+    int idx = kvs->idx_;
+    int n = kvs->node_->num_nodes_;
+    const int per_node = 8;
+    for (int j = 0; j < per_node; ++j) {
+        Key* made = Key::make_key("pk-", idx * per_node + j, 0);
+        Key* k = kvs->placed_key(made->str_);
+        delete made;
+        DataFrame* v = DataFrame::from_scalar(idx * per_node + j);
+        kvs->put(k, v);
+        if (k->idx_ != idx) {
+            delete k; // not stored locally
+            delete v;
+        }
+    }
+    kvs->barrier(); // every node has sent its puts
+    for (int i = 0; i < n * per_node; ++i) {
+        Key* made = Key::make_key("pk-", i, 0);
+        Key* k = kvs->placed_key(made->str_);
+        DataFrame* v = kvs->wait_and_get(k);
+        check(v->get_int(0, 0) == i, "Incorrect placed value");
+        if (k->idx_ != idx) delete v; // non-local
+        delete made;
+        delete k;
+    }
+    kvs->barrier(); // no node gets ahead with later tests
+    printf("Node %d: placement passed\n", idx);
+}
+
+// checks read replicas: node 0 replicates a value on 2 nodes and another on every node, and every
+// node reads both, from its own replica when it has one
+void test_replicas(KVStore* kvs) {
+    int idx = kvs->idx_;
+    int n = kvs->node_->num_nodes_;
+    Key* two = new Key("rep2", n - 1); // the replicas wrap around to node 0
+    Key* all = new Key("repall", 0);
+    if (idx == 0) {
+        DataFrame* v = DataFrame::from_scalar(2);
+        kvs->put_replicated(two, v, 2);
+        delete v; // replicas are copies
+        v = DataFrame::from_scalar(n);
+        kvs->put_replicated(all, v, 0);
+        delete v;
+    }
+    DataFrame* got = kvs->wait_and_get_replicated(two, 2);
+    check(got->get_int(0, 0) == 2, "Incorrect replicated value");
+    bool local = idx == n - 1 || (n > 1 && idx == 0);
+    Key* mine = new Key("rep2", idx);
+    check(local == (kvs->get(mine) == got), "Replica not read locally");
+    if (! local) delete got; // non-local
+    got = kvs->wait_and_get_replicated(all, 0);
+    check(got->get_int(0, 0) == n, "Incorrect replicated value");
+    kvs->barrier(); // every node has read before the next test
+    printf("Node %d: replicas passed\n", idx);
+    delete two;
+    delete all;
+    delete mine;
+}
+
+// checks removing keys: every node puts keys on the next node, then removes one of them and every
+// key with a prefix from every node
+// the puts, removes and gets of a node to the next one share a connection, so they arrive in order
+void test_remove(KVStore* kvs) {
+    int idx = kvs->idx_;
+    int n = kvs->node_->num_nodes_;
+    int next = (idx + 1) % n;
+    // every node removes only its own prefix, which no other node uses
+    StrBuff sb;
+    sb.c("rm-");
+    sb.c(idx);
+    sb.c('-');
+    char* prefix = sb.get();
+    for (int j = 0; j < 4; ++j) {
+        Key* k = Key::make_key(prefix, j, next);
+        DataFrame* v = DataFrame::from_scalar(j);
+        kvs->put(k, v);
+        if (next != idx) {
+            delete k; // not stored locally
+            delete v;
+        }
+    }
+    Key* first = Key::make_key(prefix, 0, next);
+    Key* last = Key::make_key(prefix, 3, next);
+    kvs->remove(first);
+    DataFrame* v = kvs->get(first);
+    check(v == nullptr, "Removed key still there");
+    v = kvs->get(last);
+    check(v != nullptr && v->get_int(0, 0) == 3, "Key removed with another one");
+    if (next != idx) delete v; // non-local
+    kvs->remove_prefix(prefix);
+    check(kvs->get(last) == nullptr, "Key with removed prefix still there");
+    kvs->barrier(); // every node has removed its keys
+    delete[] prefix;
+    delete first;
+    delete last;
+    printf("Node %d: remove passed\n", idx);
+}
+
+// every node puts keys under its own prefix, then lists the keys of every node in batches
+void test_scan(KVStore* kvs) {
+    int idx = kvs->idx_;
+    int n = kvs->node_->num_nodes_;
+    const int per_node = 10;
+    StrBuff sb;
+    sb.c("sc-");
+    sb.c(idx);
+    sb.c('-');
+    char* prefix = sb.get();
+    for (int j = 0; j < per_node; ++j) {
+        kvs->put(Key::make_key(prefix, j, idx), DataFrame::from_scalar(idx * 100 + j));
+    }
+    kvs->barrier(); // every node has put its keys
+
+    // every key of every node once, the keys of a node in order, with their values
+    KeyScan* all = new KeyScan(kvs, "sc-", 3, true);
+    int seen = 0;
+    while (all->next()) {
+        for (size_t i = 0; i < all->size(); ++i, ++seen) {
+            Key* k = all->key(i);
+            int node = seen / per_node;
+            check(k->idx_ == node, "Scan out of order");
+            check(all->value(i)->get_int(0, 0) == node * 100 + seen % per_node, "Wrong scan value");
+        }
+    }
+    check(seen == n * per_node, "Scan missed keys");
+    delete all;
+
+    // the keys of the next node only, in full batches followed by an empty one
+    int next = (idx + 1) % n;
+    KeyScan* one = new KeyScan(kvs, "sc-", 5, false, next);
+    seen = 0;
+    while (one->next()) {
+        check(one->size() == 5 && one->value(0) == nullptr, "Wrong scan batch");
+        seen += one->size();
+    }
+    check(seen == per_node, "Scan missed keys");
+    delete one;
+
+    kvs->barrier(); // every node is done scanning
+    kvs->remove_prefix(prefix);
+    delete[] prefix;
+    printf("Node %d: scan passed\n", idx);
+}
+
+// keeps the rows whose int in column 0 is even, and counts the rows it sees
+class EvenRower : public Rower {
+    public:
+        size_t seen_ = 0;
+
+        bool accept(Row& r) {
+            ++seen_;
+            return r.get_int(0) % 2 == 0;
+        }
+};
+
+// checks the aggregates of column 0 of the given distributed dataframe
+void check_aggregates_(DistributedDataFrame* ddf, int sum, int min, int max) {
+    DataFrame* a = ddf->aggregate(0, MergeOp::Add);
+    check(a->get_int(0, 0) == sum, "Incorrect distributed sum");
+    delete a;
+    a = ddf->aggregate(0, MergeOp::Min);
+    check(a->get_int(0, 0) == min, "Incorrect distributed min");
+    delete a;
+    a = ddf->aggregate(0, MergeOp::Max);
+    check(a->get_int(0, 0) == max, "Incorrect distributed max");
+    delete a;
+}
+
+// checks a distributed dataframe split by node 0 and one made of the rows of every node
+void test_distributed(KVStore* kvs) {
+    int idx = kvs->idx_;
+    int n = kvs->node_->num_nodes_;
+
+    // 0, ..., 19 in chunks of 3 rows
+    DataFrame* df = nullptr;
+    if (idx == 0) {
+        int vals[20];
+        for (int i = 0; i < 20; ++i) vals[i] = i;
+        df = DataFrame::from_array(20, vals);
+    }
+    DistributedDataFrame* ddf = DistributedDataFrame::from_df(kvs, "ddf", df, 3, 0);
+    delete df;
+    check(ddf->nrows() == 20 && ddf->nchunks_ == 7, "Incorrect distributed split");
+    check_aggregates_(ddf, 190, 0, 19);
+    DataFrame* last = ddf->chunk(6);
+    check(last->nrows() == 2 && last->get_int(0, 1) == 19, "Incorrect distributed chunk");
+    if (! ddf->is_local(6)) delete last;
+
+    EvenRower er;
+    DistributedDataFrame* even = ddf->filter(er);
+    check(even->nrows() == 10, "Incorrect distributed filter");
+    check_aggregates_(even, 90, 0, 18);
+    even->drop(); // each node only used its own chunks
+    // every row is seen by exactly one node
+    DataFrame* seen = DataFrame::from_scalar((int)er.seen_);
+    DataFrame* all_seen = kvs->allreduce("ddf-seen", MergeOp::Add, seen);
+    check(all_seen->get_int(0, 0) == 20, "Distributed rows not seen once");
+
+    // node i has i + 1 rows of i
+    int* mine = new int[idx + 1];
+    for (int i = 0; i <= idx; ++i) mine[i] = idx;
+    DistributedDataFrame* loc = DistributedDataFrame::from_local(kvs, "loc",
+            DataFrame::from_array(idx + 1, mine));
+    check(loc->nrows() == (size_t)(n * (n + 1) / 2), "Incorrect distributed local rows");
+    int sum = 0;
+    for (int i = 0; i < n; ++i) sum += i * (i + 1);
+    check_aggregates_(loc, sum, 0, n - 1);
+
+    printf("Node %d: distributed dataframe passed\n", idx);
+    delete[] mine;
+    delete seen;
+    delete all_seen;
+    // the sum of each chunk, computed where it is stored
+    SumRower sr(0);
+    DataFrame** sums = ddf->execute(sr);
+    for (size_t i = 0; i < 7; ++i) {
+        int from = 3 * i;
+        int to = from + 3 < 20 ? from + 3 : 20;
+        check(sums[i]->get_int(0, 0) == (to - 1) * to / 2 - (from - 1) * from / 2,
+                "Incorrect distributed execute");
+        delete sums[i];
+    }
+    delete[] sums;
+
+    delete ddf;
+    delete even;
+    delete loc;
+}
 
 // Usage: ./node <node_addr>
 int main(int argc, char** argv) {
     check(argc == 2, "Usage: ./node <node_addr>");
     KVStore* kvs = new KVStore(argv[1]);
-    
+    running_kvs = kvs;
+    kvs->register_rower("sum", SumRower::make);
+    kvs->register_rower("gate", GateRower::make);
+    test_collectives(kvs);
+    test_barrier(kvs);
+    test_execute(kvs);
+    test_placement(kvs);
+    test_replicas(kvs);
+    test_remove(kvs);
+    test_scan(kvs);
+    test_distributed(kvs);
+    // the last call is a collective, so its last messages can still be on their way when node 0
+    // starts the teardown - the network is only torn down once every node is deleted
+    DataFrame* one = DataFrame::from_scalar(1);
+    DataFrame* all = kvs->allreduce("last", MergeOp::Add, one);
+    check(all->get_int(0, 0) == (int)kvs->node_->num_nodes_, "Incorrect last allreduce");
+    delete one;
+    delete all;
     if (kvs->idx_ == 0) {
         kvs->teardown();
     }
@@ -5,6 +5,7 @@
 #include <cstdlib>
 #include <cstring>
 #include <iostream>
+#include <stdint.h>
 
 // Error with message
 void error(const char* msg) {
@@ -23,6 +24,11 @@ bool streq(const char* str1, const char* str2) {
     else return strcmp(str1, str2) == 0;
 }
 
+// returns true if the given string starts with the given prefix
+bool starts_with(const char* str, const char* prefix) {
+    return strncmp(str, prefix, strlen(prefix)) == 0;
+}
+
 //testing float equality
 bool float_eq(float f1, float f2) {
     return (f1 - f2) < 0.01 || (f1 - f2) > -0.01;
@@ -35,6 +41,43 @@ int mod(int n1, int n2) {
     return (n1 % n2 + n2) % n2;
 }
 
+// mixes the bits of the given value so every input bit affects every output bit
+// (the finalizer of MurmurHash3)
+uint64_t mix64(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+// hashes the given bytes into 64 bits, 8 bytes at a time (based on MurmurHash3)
+// different seeds give independent hashes of the same bytes
+uint64_t hash_bytes(const char* data, size_t len, uint64_t seed) {
+    const uint64_t c1 = 0x87c37b91114253d5ULL;
+    const uint64_t c2 = 0x4cf5ad432745937fULL;
+    uint64_t h = seed ^ (len * c1);
+    size_t i = 0;
+    for (; i + 8 <= len; i += 8) {
+        uint64_t k;
+        memcpy(&k, data + i, 8);
+        k *= c1;
+        k = (k << 31) | (k >> 33);
+        k *= c2;
+        h ^= k;
+        h = ((h << 27) | (h >> 37)) * 5 + 0x52dce729;
+    }
+    // the last 0 - 7 bytes
+    uint64_t k = 0;
+    for (size_t j = len; j > i; --j) k = (k << 8) | (unsigned char)data[j - 1];
+    k *= c2;
+    k = (k << 33) | (k >> 31);
+    k *= c1;
+    h ^= k;
+    return mix64(h);
+}
+
 // Printing functions
 void p(char* c) { std::cout << c; }
 void p(bool c) { std::cout << c; }
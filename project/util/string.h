@@ -135,6 +135,12 @@ public:
         memcpy(val_+size_, str, step);
         size_ += step;
     }
+    // concats the first len characters of the given string
+    void c(const char* str, size_t len) {
+        grow_by_(len);
+        memcpy(val_+size_, str, len);
+        size_ += len;
+    }
     void c(char c) {
         grow_by_(1);
         val_[size_] = c;
@@ -50,3 +50,45 @@ class Lock : public Object {
         // Notify all threads waiting on this lock
         void notify_all() { cv_.notify_all(); }
 };
+
+/** A reader-writer lock: any number of readers or a single writer hold it at a time.
+ *  A waiting writer blocks new readers, so writers are not starved by a stream of reads. */
+class RWLock : public Object {
+    public:
+        std::mutex mtx_;
+        std::condition_variable cv_;
+        size_t readers_; // number of threads holding the lock for reading
+        size_t writers_waiting_; // number of threads waiting to write
+        bool writer_; // true if a thread holds the lock for writing
+
+        RWLock() : Object(), readers_(0), writers_waiting_(0), writer_(false) { }
+
+        /** Request shared ownership of this lock, blocks while a writer holds or waits for it */
+        void lock_read() {
+            std::unique_lock<std::mutex> l(mtx_);
+            cv_.wait(l, [this]{ return !writer_ && writers_waiting_ == 0; });
+            ++readers_;
+        }
+
+        /** Release shared ownership of this lock */
+        void unlock_read() {
+            std::unique_lock<std::mutex> l(mtx_);
+            if (--readers_ == 0) cv_.notify_all();
+        }
+
+        /** Request exclusive ownership of this lock, blocks until no one else holds it */
+        void lock_write() {
+            std::unique_lock<std::mutex> l(mtx_);
+            ++writers_waiting_;
+            cv_.wait(l, [this]{ return !writer_ && readers_ == 0; });
+            --writers_waiting_;
+            writer_ = true;
+        }
+
+        /** Release exclusive ownership of this lock */
+        void unlock_write() {
+            std::unique_lock<std::mutex> l(mtx_);
+            writer_ = false;
+            cv_.notify_all();
+        }
+};